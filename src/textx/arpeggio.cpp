@@ -1,6 +1,7 @@
 // C++ regex seem to have problems with some regular expressions, e.g. in "FLOAT: ..."
 
 #include "textx/arpeggio.h"
+#include <array>
 #ifdef ARPEGGIO_USE_BOOST_FOR_REGEX
 #include <boost/regex.hpp>
 #else
@@ -43,7 +44,27 @@ namespace textx
             {MatchType::custom, false},
         };
 
-        size_t ParserState::cache_reset_indicator_source = 1; 
+        MemoryUsage memory_usage(const Match &match)
+        {
+            MemoryUsage res;
+            match.traverse([&](const Match &m) {
+                res.add(m.children);
+                if (m.name.has_value()) res.add(m.name.value());
+                if (m.captured.has_value()) res.add(m.captured.value());
+            });
+            return res;
+        }
+
+        MemoryUsage memory_usage(const MemoTable &memo)
+        {
+            MemoryUsage res;
+            if (memo.bucket_count()>1) res.add(memo.bucket_count()*sizeof(void*)); // a single bucket is not allocated
+            for (auto &[key, match]: memo) {
+                res.add(sizeof(MemoTable::value_type)+2*sizeof(void*)); // node: next pointer, value and cached hash
+                if (match.has_value()) res += memory_usage(match.value());
+            }
+            return res;
+        }
 
 
         void ParserState::update_farthest_position(TextPosition pos, MatchType type, std::string_view info)
@@ -137,262 +158,321 @@ namespace textx
             s << "...\n";
         }
 
-        Pattern optional(Pattern pattern)
-        {
-            return rule({[=](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
+        namespace details {
+            std::vector<bool> get_is_optional(std::vector<Pattern> patterns) {
+                std::vector<bool> is_optional={};
+                std::transform(
+                    patterns.begin(),
+                    patterns.end(),
+                    std::back_inserter(is_optional),
+                    [](auto p)->bool{return p.type()==MatchType::optional;}
+                );
+                return is_optional;
+            }
+        }
+
+        namespace raw {
+            Pattern optional(Pattern pattern)
+            {
+                return {[=](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
+                            {
+                        auto match = pattern(config, text, pos);
+                        if (match.has_value())
                         {
-                    auto match = pattern(config, text, pos);
-                    if (match.has_value())
+                            return Match{match.value().start(), match.value().end(), MatchType::optional, {match.value()}};
+                        }
+                        else {
+                            return Match{pos, pos, MatchType::optional, {}};
+                        }
+                    }, MatchType::optional};
+            }
+
+            Pattern str_match(std::string s)
+            {
+                return {[=](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
+                            {
+                    if (text.str().substr(pos).starts_with(s))
                     {
-                        return Match{match.value().start(), match.value().end(), MatchType::optional, {match.value()}};
-                    }
-                    else {
-                        return Match{pos, pos, MatchType::optional, {}};
+                        return Match{pos, pos.add(text, s.length()), MatchType::str_match};
                     }
-                }, MatchType::optional});
-        }
+                    else
+                    {
+                        text.update_farthest_position(pos,MatchType::str_match,s);
+                        return std::nullopt;
+                    } }, MatchType::str_match};
+            }
 
-        Pattern str_match(std::string s)
-        {
-            return rule({[=](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
-                        {
-                if (text.str().substr(pos).starts_with(s))
-                {
-                    return Match{pos, pos.add(text, s.length()), MatchType::str_match};
+            Pattern str_choice(std::vector<std::string> literals)
+            {
+                std::array<bool,256> first_chars{};
+                bool has_empty_literal = false;
+                for (auto &l: literals) {
+                    if (l.empty()) has_empty_literal = true;
+                    else first_chars[static_cast<unsigned char>(l[0])] = true;
                 }
-                else
-                {
-                    text.update_farthest_position(pos,MatchType::str_match,s);
-                    return std::nullopt;
-                } }, MatchType::str_match});
-        }
+                return {[=](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
+                            {
+                    auto rest = text.str().substr(pos);
+                    // quick reject: no literal can start here
+                    if (!has_empty_literal && (rest.empty() || !first_chars[static_cast<unsigned char>(rest[0])])) {
+                        for (auto &l: literals) {
+                            text.update_farthest_position(pos,MatchType::str_match,l);
+                        }
+                        return std::nullopt;
+                    }
+                    for (auto &l: literals)
+                    {
+                        if (rest.starts_with(l))
+                        {
+                            Match match{pos, pos.add(text, l.length()), MatchType::str_match};
+                            return Match{match.start(), match.end(), MatchType::ordered_choice, {match}};
+                        }
+                        text.update_farthest_position(pos,MatchType::str_match,l);
+                    }
+                    return std::nullopt; }, MatchType::ordered_choice};
+            }
 
-        Pattern regex_match(std::string s)
-        {
+            Pattern regex_match(std::string s)
+            {
 #ifdef ARPEGGIO_USE_BOOST_FOR_REGEX
-            using boost::match_results;
-            using boost::regex;
-            using boost::regex_search;
-            //using boost::regex_constants::match_not_dot_newline;
-            auto myregex = regex{s};
+                using boost::match_results;
+                using boost::regex;
+                using boost::regex_search;
+                //using boost::regex_constants::match_not_dot_newline;
+                auto myregex = regex{s};
 #else
-            //TODO not working with certain regex situations...
-            using std::match_results;
-            using std::regex;
-            using std::regex_search;
-            auto myregex = regex{s};
+                //TODO not working with certain regex situations...
+                using std::match_results;
+                using std::regex;
+                using std::regex_search;
+                auto myregex = regex{s};
 #endif
-            return rule({[=, r = myregex](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
-                        {
-                match_results<std::string_view::const_iterator> smatch;
-                if (regex_search(text.str().begin() + pos, text.str().end(), smatch, r))
-                {
-                    if (smatch.position() == 0) {
-                        auto res = Match{pos, pos.add(text,smatch.length()), MatchType::regex_match};
-                        return res;
+                return {[=, r = myregex](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
+                            {
+                    match_results<std::string_view::const_iterator> smatch;
+                    if (regex_search(text.str().begin() + pos, text.str().end(), smatch, r))
+                    {
+                        if (smatch.position() == 0) {
+                            auto res = Match{pos, pos.add(text,smatch.length()), MatchType::regex_match};
+                            return res;
+                        }
                     }
-                }
-                // else - no match as index 0 found, no return so far...
+                    // else - no match as index 0 found, no return so far...
 
-                //text.update_farthest_position(pos,MatchType::regex_match,s);
-                return std::nullopt; },MatchType::regex_match});
-        }
+                    //text.update_farthest_position(pos,MatchType::regex_match,s);
+                    return std::nullopt; }, MatchType::regex_match};
+            }
 
-        Pattern sequence(std::vector<Pattern> patterns)
-        {
-            return rule({[=](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
-                        {
-                Match match{pos, pos, MatchType::sequence};
-                for (auto pattern : patterns)
-                {
-                    auto sub_match = pattern(config, text, pos);
-                    if (sub_match)
-                    {
-                        pos = sub_match.value().end();
-                        match.update_end(pos);
-                        match.children.push_back(sub_match.value());
-                    }
-                    else
+            Pattern sequence(std::vector<Pattern> patterns)
+            {
+                return {[=](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
+                            {
+                    Match match{pos, pos, MatchType::sequence};
+                    for (const auto &pattern : patterns)
                     {
-                        return std::nullopt;
+                        auto sub_match = pattern(config, text, pos);
+                        if (sub_match)
+                        {
+                            pos = sub_match.value().end();
+                            match.update_end(pos);
+                            match.children.push_back(sub_match.value());
+                        }
+                        else
+                        {
+                            return std::nullopt;
+                        }
                     }
-                }
-                return match; },MatchType::sequence});
-        }
+                    return match; }, MatchType::sequence};
+            }
 
-        Pattern ordered_choice(std::vector<Pattern> patterns)
-        {
-            return rule({[=](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
-                        {
-                for (auto pattern : patterns)
-                {
-                    auto match = pattern(config, text, pos);
-                    if (match)
+            Pattern ordered_choice(std::vector<Pattern> patterns)
+            {
+                return {[=](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
+                            {
+                    for (const auto &pattern : patterns)
                     {
-                        return Match{match.value().start(),match.value().end(),MatchType::ordered_choice, {match.value()}};
+                        auto match = pattern(config, text, pos);
+                        if (match)
+                        {
+                            return Match{match.value().start(),match.value().end(),MatchType::ordered_choice, {match.value()}};
+                        }
                     }
-                }
-                return std::nullopt; },MatchType::ordered_choice});
-        }
-
-        namespace details {
-            std::vector<bool> get_is_optional(std::vector<Pattern> patterns) {
-                std::vector<bool> is_optional={};
-                std::transform(
-                    patterns.begin(),
-                    patterns.end(),
-                    std::back_inserter(is_optional),
-                    [](auto p)->bool{return p.type()==MatchType::optional;}
-                );
-                return is_optional;
+                    return std::nullopt; }, MatchType::ordered_choice};
             }
-        }
 
-        Pattern unordered_group(std::vector<Pattern> patterns, std::optional<Pattern> separator)
-        {
-            auto is_optional = details::get_is_optional(patterns);
-            size_t optional_elements_n = std::count_if(is_optional.begin(), is_optional.end(), [](bool x){return x;});
+            Pattern unordered_group(std::vector<Pattern> patterns, std::optional<Pattern> separator)
+            {
+                auto is_optional = details::get_is_optional(patterns);
+                size_t optional_elements_n = std::count_if(is_optional.begin(), is_optional.end(), [](bool x){return x;});
 
-            return rule({[=](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
-                        {
-                Match result{pos,pos,MatchType::unordered_group, {}};
-                std::vector<bool> used(patterns.size());
-                std::fill(used.begin(), used.end(), false);
-                size_t n_req = 0;
-                size_t n_opt = 0;
-                size_t n = 0;
+                return {[=](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
+                            {
+                    Match result{pos,pos,MatchType::unordered_group, {}};
+                    std::vector<bool> used(patterns.size());
+                    std::fill(used.begin(), used.end(), false);
+                    size_t n_req = 0;
+                    size_t n_opt = 0;
+                    size_t n = 0;
 
-                for (size_t t=0;t<patterns.size();t++) {
-                    for (size_t i=0;i<patterns.size();i++) {
-                        if (!used[i]) {
-                            bool ok = true;
-                            TextPosition npos = pos;
-                            if (n>0 && separator.has_value()) {
-                                auto sep_match = separator.value()(config, text, pos);
-                                if (sep_match) {
-                                    npos = sep_match.value().end(); 
+                    for (size_t t=0;t<patterns.size();t++) {
+                        for (size_t i=0;i<patterns.size();i++) {
+                            if (!used[i]) {
+                                bool ok = true;
+                                TextPosition npos = pos;
+                                if (n>0 && separator.has_value()) {
+                                    auto sep_match = separator.value()(config, text, pos);
+                                    if (sep_match) {
+                                        npos = sep_match.value().end(); 
+                                    }
+                                    else {
+                                        ok = false;
+                                    }
                                 }
-                                else {
-                                    ok = false;
-                                }
-                            }
-                            if (ok) {
-                                auto match = patterns[i](config, text, npos);
-                                if (match && is_optional[i] && match->start()==match->end()) {
-                                    match = std::nullopt; // empty optional match
-                                }
-                                if (match)
-                                {
-                                    result.children.emplace_back(match.value());
-                                    pos = match.value().end();
-                                    used[i] = true;
-                                    n++;
-                                    if (is_optional[i]) n_opt++;
-                                    else n_req++;
+                                if (ok) {
+                                    auto match = patterns[i](config, text, npos);
+                                    if (match && is_optional[i] && match->start()==match->end()) {
+                                        match = std::nullopt; // empty optional match
+                                    }
+                                    if (match)
+                                    {
+                                        result.children.emplace_back(match.value());
+                                        pos = match.value().end();
+                                        used[i] = true;
+                                        n++;
+                                        if (is_optional[i]) n_opt++;
+                                        else n_req++;
+                                    }
                                 }
                             }
                         }
                     }
-                }
-                result.update_end(pos);
+                    result.update_end(pos);
                 
-                /* TODO remove comments below...
+                    /* TODO remove comments below...
 
-                "... If all elements are optional then even if there is no match of any of the 
-                optional parts the whole match still succeeds. At least that's how it should
-                work and a quick test confirms it. The only issue I noticed is that if the
-                whole unordered match is contained in a single common rule than a reference 
-                to that rule will return None in case all optionals are not matched. Is this 
-                "the correct" behavior I don't know. It can be either this or to return an 
-                object where all attributes are None. We can investigate this as a separate 
-                issue if needed.
-                */
-                /*if (n==0) return std::nullopt; // special case, nothing was found
-                else*/ 
+                    "... If all elements are optional then even if there is no match of any of the 
+                    optional parts the whole match still succeeds. At least that's how it should
+                    work and a quick test confirms it. The only issue I noticed is that if the
+                    whole unordered match is contained in a single common rule than a reference 
+                    to that rule will return None in case all optionals are not matched. Is this 
+                    "the correct" behavior I don't know. It can be either this or to return an 
+                    object where all attributes are None. We can investigate this as a separate 
+                    issue if needed.
+                    */
+                    /*if (n==0) return std::nullopt; // special case, nothing was found
+                    else*/ 
                 
-                if (n_req == patterns.size()-optional_elements_n) return result;
-                else return std::nullopt; }, MatchType::unordered_group});
-        }
+                    if (n_req == patterns.size()-optional_elements_n) return result;
+                    else return std::nullopt; }, MatchType::unordered_group};
+            }
 
-        Pattern negative_lookahead(Pattern pattern)
-        {
-            return rule({[=](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
-                        {
-                auto match = pattern(config, text, pos);
-                if (!match)
-                {
-                    return Match{pos, pos,MatchType::negative_lookahead};
-                }
-                else
-                {
-                    return std::nullopt;
-                } },MatchType::negative_lookahead});
-        }
+            Pattern negative_lookahead(Pattern pattern)
+            {
+                return {[=](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
+                            {
+                    auto match = pattern(config, text, pos);
+                    if (!match)
+                    {
+                        return Match{pos, pos,MatchType::negative_lookahead};
+                    }
+                    else
+                    {
+                        return std::nullopt;
+                    } }, MatchType::negative_lookahead};
+            }
 
-        Pattern positive_lookahead(Pattern pattern)
-        {
-            return rule({[=](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
-                        {
-                auto match = pattern(config, text, pos);
-                if (match)
-                {
-                    return Match{pos, pos, MatchType::positive_lookahead, {match.value()}};
-                }
-                else
-                {
-                    return std::nullopt;
-                } },MatchType::positive_lookahead});
-        }
+            Pattern positive_lookahead(Pattern pattern)
+            {
+                return {[=](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
+                            {
+                    auto match = pattern(config, text, pos);
+                    if (match)
+                    {
+                        return Match{pos, pos, MatchType::positive_lookahead, {match.value()}};
+                    }
+                    else
+                    {
+                        return std::nullopt;
+                    } }, MatchType::positive_lookahead};
+            }
 
-        Pattern one_or_more(Pattern pattern)
-        {
-            return rule({[=](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
+            Pattern one_or_more(Pattern pattern)
+            {
+                return {[=](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
+                            {
+                    auto sub_match = pattern(config, text, pos);
+                    if (!sub_match)
+                    {
+                        return std::nullopt;
+                    }
+                    else
+                    {
+                        auto match = Match{sub_match.value().start(), sub_match.value().end(), MatchType::one_or_more, {sub_match.value()}};
+                        pos = match.end();
+                        while (auto next_match = pattern(config, text, pos))
                         {
-                auto sub_match = pattern(config, text, pos);
-                if (!sub_match)
-                {
-                    return std::nullopt;
-                }
-                else
-                {
-                    auto match = Match{sub_match.value().start(), sub_match.value().end(), MatchType::one_or_more, {sub_match.value()}};
-                    pos = match.end();
+                            match.children.push_back(next_match.value());
+                            pos = next_match.value().end();
+                            match.update_end(pos);
+                        }
+                        return match;
+                    } }, MatchType::one_or_more};
+            }
+ 
+            Pattern zero_or_more(Pattern pattern)
+            {
+                return {[=](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
+                            {
+                    auto match = Match{pos, pos,MatchType::zero_or_more, {}};
                     while (auto next_match = pattern(config, text, pos))
                     {
                         match.children.push_back(next_match.value());
                         pos = next_match.value().end();
                         match.update_end(pos);
                     }
-                    return match;
-                } },MatchType::one_or_more});
+                    return match; }, MatchType::zero_or_more};
+            }
+
+            Pattern end_of_file()
+            {
+                return {[=](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
+                            {
+                    if (pos==text.length()) {
+                        return Match{pos,pos,MatchType::end_of_file};
+                    }
+                    else {
+                        text.update_farthest_position(pos,MatchType::end_of_file,"");
+                        return std::nullopt;
+                    } }, MatchType::end_of_file};
+            }
         }
- 
-        Pattern zero_or_more(Pattern pattern)
+
+        Pattern skip(Pattern pattern)
         {
-            return rule({[=](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
-                        {
-                auto match = Match{pos, pos,MatchType::zero_or_more, {}};
-                while (auto next_match = pattern(config, text, pos))
+            return {[=](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
+            {
+                if (pos > text.length())
                 {
-                    match.children.push_back(next_match.value());
-                    pos = next_match.value().end();
-                    match.update_end(pos);
+                    throw std::runtime_error("unexpected: pos>text.length()");
                 }
-                return match; },MatchType::zero_or_more});
-        }
-
-        Pattern end_of_file()
-        {
-            return rule({[=](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
-                        {
-                if (pos==text.length()) {
-                    return Match{pos,pos,MatchType::end_of_file};
+                if (pattern.type()!=MatchType::optional && pattern.type()!=MatchType::zero_or_more) {
+                    pos = config.skip_text(text, pos);
                 }
-                else {
-                    text.update_farthest_position(pos,MatchType::end_of_file,"");
-                    return std::nullopt;
-                } },MatchType::end_of_file});
+                return pattern(config, text, pos);
+            }, pattern.type()};
         }
 
+        Pattern optional(Pattern pattern) { return rule(raw::optional(pattern)); }
+        Pattern str_match(std::string s) { return rule(raw::str_match(s)); }
+        Pattern str_choice(std::vector<std::string> literals) { return rule(raw::str_choice(literals)); }
+        Pattern regex_match(std::string s) { return rule(raw::regex_match(s)); }
+        Pattern sequence(std::vector<Pattern> patterns) { return rule(raw::sequence(patterns)); }
+        Pattern ordered_choice(std::vector<Pattern> patterns) { return rule(raw::ordered_choice(patterns)); }
+        Pattern unordered_group(std::vector<Pattern> patterns, std::optional<Pattern> separator) { return rule(raw::unordered_group(patterns, separator)); }
+        Pattern negative_lookahead(Pattern pattern) { return rule(raw::negative_lookahead(pattern)); }
+        Pattern positive_lookahead(Pattern pattern) { return rule(raw::positive_lookahead(pattern)); }
+        Pattern one_or_more(Pattern pattern) { return rule(raw::one_or_more(pattern)); }
+        Pattern zero_or_more(Pattern pattern) { return rule(raw::zero_or_more(pattern)); }
+        Pattern end_of_file() { return rule(raw::end_of_file()); }
     }
 }
\ No newline at end of file
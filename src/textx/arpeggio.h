@@ -13,6 +13,8 @@
 #include <tuple>
 #include <compare>
 #include <functional>
+#include <atomic>
+#include "textx/memory_stats.h"
 
 #define DBG_TEXTX_ARPEGGIO(x)
 #define DBG_TEXTX_ARPEGGIO_FOUND(x) DBG_TEXTX_ARPEGGIO(x)
@@ -178,11 +180,25 @@ namespace textx
             }
         };
 
+        /** memoization key: id of the rule (see rule()) and text position */
+        struct MemoKey {
+            size_t rule;
+            size_t pos;
+            bool operator==(const MemoKey&) const = default;
+        };
+        struct MemoKeyHash {
+            size_t operator()(const MemoKey& k) const { return std::hash<size_t>{}(k.rule*0x9e3779b97f4a7c15ull ^ k.pos); }
+        };
+        using MemoTable = std::unordered_map<MemoKey, std::optional<Match>, MemoKeyHash>;
+
+        /** heap memory of the children and names of a match (not of the match itself) */
+        MemoryUsage memory_usage(const Match &match);
+        /** heap memory of a memo table incl. the stored matches */
+        MemoryUsage memory_usage(const MemoTable &memo);
+
         class ParserState
         {
             std::string_view source;
-            static size_t cache_reset_indicator_source;
-            size_t cache_reset_indicator = {cache_reset_indicator_source++};
 
         public:
             bool eolterm = false;
@@ -190,8 +206,8 @@ namespace textx
             size_t cache_hits = {0};
             size_t cache_misses = {0};
             AnnotatedTextPosition farthest_position = {};
+            MemoTable memo = {}; /// results of all rules of one parse (see rule())
 
-            size_t get_cache_reset_indicator() { return cache_reset_indicator; }
             ParserState(std::string_view s) : source(s) {}
             operator std::string_view() { return source; }
             size_t length() { return source.length(); }
@@ -266,10 +282,10 @@ namespace textx
             std::optional<textx::arpeggio::Match> operator()(const textx::arpeggio::Config &config, textx::arpeggio::ParserState &text, textx::arpeggio::TextPosition pos) const {
                 return patternfunc(config, text, pos);
             }
-            MatchType type() { return type_value; }
+            MatchType type() const { return type_value; }
         };
 
-        inline std::string_view get_str(std::string_view text, Match match)
+        inline std::string_view get_str(std::string_view text, const Match &match)
         {
             return text.substr(match.start(), match.end() - match.start());
         }
@@ -291,7 +307,8 @@ namespace textx
          */
         inline Pattern rule(Pattern pattern)
         {
-            return {[=, cache = std::unordered_map<size_t, std::optional<Match>>{}, chached_state = static_cast<size_t>(0)](const Config &config, ParserState &text, TextPosition pos) mutable -> std::optional<Match>
+            static std::atomic<size_t> next_rule_id = 1;
+            return {[=, id = next_rule_id++](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
             {
                 // basic checks:
                 if (pos > text.length())
@@ -302,21 +319,17 @@ namespace textx
                     pos = config.skip_text(text, pos);
                 }
                 
-                // memoization:
-                if (chached_state != text.get_cache_reset_indicator())
-                {
-                    chached_state = text.get_cache_reset_indicator();
-                    cache = {};
-                }
-                if (cache.count(pos.pos) > 0)
+                // memoization (references to entries stay valid when the table grows):
+                auto [entry, inserted] = text.memo.try_emplace(MemoKey{id, pos.pos}, std::nullopt); // recursion breaker
+                auto &cached = entry->second;
+                if (!inserted)
                 {
                     text.cache_hits++;
-                    return cache[pos.pos];
+                    return cached;
                 }
                 else
                 {
                     text.cache_misses++;
-                    cache[pos.pos] = std::nullopt; // recursion breaker
 
                     auto match = pattern(config, text, pos);
 
@@ -329,7 +342,7 @@ namespace textx
                             raise(match->start(), s.str());
                         }
                     }
-                    cache[pos.pos] = match;
+                    cached = match;
                     return match;
                 }
             }, pattern.type()}; // forward type
@@ -372,12 +385,13 @@ namespace textx
         {
             return {[=](const Config &config, ParserState &text, TextPosition pos) -> std::optional<Match>
                         {
-                auto copy = text;
+                // restore the flags (the memo table and error infos are preserved):
+                auto eolterm = text.eolterm;
+                auto skipws = text.skipws;
                 modifier(text);
                 auto match = pattern(config, text, pos);
-                // preserve error infos:
-                copy.farthest_position = text.farthest_position;
-                text = copy;
+                text.eolterm = eolterm;
+                text.skipws = skipws;
                 return match;
                         }, pattern.type()};
         }
@@ -407,8 +421,16 @@ namespace textx
             std::vector<bool> get_is_optional(std::vector<Pattern> patterns);
         }
 
+        /**
+         * Lightweight variant of rule(): skips text like rule(), but does no memoization.
+         * Used for sub-expressions of compiled grammar rules (see textx/expression.h).
+         */
+        Pattern skip(Pattern pattern);
+
         Pattern optional(Pattern pattern);
         Pattern str_match(std::string s);
+        /** ordered choice of plain string literals (first matching literal wins) */
+        Pattern str_choice(std::vector<std::string> literals);
         Pattern regex_match(std::string s);
         Pattern sequence(std::vector<Pattern> patterns);
         Pattern ordered_choice(std::vector<Pattern> patterns);
@@ -419,5 +441,24 @@ namespace textx
         Pattern zero_or_more(Pattern pattern);
         Pattern end_of_file();
 
+        /**
+         * The combinators without the rule() decorator (no text skipping, no
+         * memoization). The functions above are rule(raw::...).
+         */
+        namespace raw {
+            Pattern optional(Pattern pattern);
+            Pattern str_match(std::string s);
+            Pattern str_choice(std::vector<std::string> literals);
+            Pattern regex_match(std::string s);
+            Pattern sequence(std::vector<Pattern> patterns);
+            Pattern ordered_choice(std::vector<Pattern> patterns);
+            Pattern unordered_group(std::vector<Pattern> patterns, std::optional<Pattern> separator=std::nullopt);
+            Pattern negative_lookahead(Pattern pattern);
+            Pattern positive_lookahead(Pattern pattern);
+            Pattern one_or_more(Pattern pattern);
+            Pattern zero_or_more(Pattern pattern);
+            Pattern end_of_file();
+        }
+
     }
 }
\ No newline at end of file
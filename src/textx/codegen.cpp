@@ -0,0 +1,235 @@
+#include "textx/codegen.h"
+#include "textx/rule.h"
+#include <sstream>
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+
+namespace textx::codegen {
+
+    namespace {
+        struct Field {
+            std::string attr;           /// attribute name
+            std::string member;         /// member name (attr, or attr_ for C++ keywords)
+            std::string type = {};      /// element type
+            std::string init = {};      /// initializer of scalar members
+            std::string getter = {};    /// conversion function (followed by the value and ")")
+            bool list = false;
+            bool uses_index = false;
+        };
+
+        std::string member_name(const std::string& name) {
+            static const std::unordered_set<std::string> keywords = {
+                "alignas", "alignof", "and", "asm", "auto", "bool", "break", "case", "catch", "char", "class",
+                "const", "constexpr", "continue", "default", "delete", "do", "double", "else", "enum", "explicit",
+                "export", "extern", "false", "float", "for", "friend", "goto", "if", "inline", "int", "long",
+                "mutable", "namespace", "new", "noexcept", "not", "nullptr", "operator", "or", "private",
+                "protected", "public", "register", "return", "short", "signed", "sizeof", "static", "struct",
+                "switch", "template", "this", "throw", "true", "try", "typedef", "typename", "union", "unsigned",
+                "using", "virtual", "void", "volatile", "while", "xor"
+            };
+            return keywords.count(name)>0 ? name+"_" : name;
+        }
+
+        Field make_field(const Rule& rule, const std::string& name, const AttributeInfo& info, const std::unordered_set<std::string>& structs, const std::unordered_set<std::string>& abstract) {
+            Field f{name, member_name(name)};
+            f.list = info.cardinality==AttributeCardinality::list;
+            if (info.is_boolean()) {
+                f.type = "bool"; f.init = "false"; f.getter = "textx::codegen::get_bool(";
+            }
+            else if (info.is_str()) {
+                auto text_type = textx::object::TextType::other;
+                if (info.match_types.size()>0 && std::all_of(info.match_types.begin(), info.match_types.end(), [&](auto &t) { return t==info.match_types[0]; })) {
+                    text_type = textx::object::text_type_of_rule(info.match_types[0]);
+                }
+                switch (text_type) {
+                    case textx::object::TextType::INT:
+                        f.type = "long long"; f.init = "0"; f.getter = "textx::codegen::get_int(";
+                        break;
+                    case textx::object::TextType::FLOAT:
+                    case textx::object::TextType::STRICTFLOAT:
+                    case textx::object::TextType::NUMBER:
+                        f.type = "double"; f.init = "0"; f.getter = "textx::codegen::get_float(";
+                        break;
+                    case textx::object::TextType::BOOL:
+                        f.type = "bool"; f.init = "false"; f.getter = "textx::codegen::get_bool(";
+                        break;
+                    default:
+                        f.type = "std::string"; f.init = "{}"; f.getter = "textx::codegen::get_str(";
+                }
+            }
+            else if (info.is_obj()) {
+                auto type = info.type.value();
+                if (type=="OBJECT") {
+                    type = "textx::codegen::GeneratedObject";
+                }
+                else if (structs.count(type)==0) {
+                    throw std::runtime_error("codegen: type "+type+" of "+rule.tx_name()+"."+name+" is not a rule of the metamodel (imported grammars are not supported)");
+                }
+                f.getter = "textx::codegen::get_obj<"+type+">(";
+                f.type = (abstract.count(type)>0) ? "textx::codegen::Ptr<"+type+">" : type+"*";
+                f.init = "nullptr";
+                f.uses_index = true;
+            }
+            else { // more than one possible type
+                if (info.maybe_obj() && info.type.has_value() && info.type.value()!="OBJECT" && structs.count(info.type.value())==0) {
+                    throw std::runtime_error("codegen: type "+info.type.value()+" of "+rule.tx_name()+"."+name+" is not a rule of the metamodel (imported grammars are not supported)");
+                }
+                f.type = "const textx::object::Value*"; f.init = "nullptr"; f.getter = "textx::codegen::get_value(";
+            }
+            return f;
+        }
+
+        std::string call(const Field& f, const std::string& value) {
+            return f.getter+value+(f.uses_index ? ", index)" : ")");
+        }
+    }
+
+    std::string generate_cpp(const textx::Metamodel& mm, const Options& options) {
+        std::vector<const Rule*> abstract_rules, common_rules;
+        for (auto &[name, rule]: mm) {
+            if (rule.type()==RuleType::abstract) abstract_rules.push_back(&rule);
+            else if (rule.type()==RuleType::common) common_rules.push_back(&rule);
+        }
+        auto by_name = [](const Rule* a, const Rule* b) { return a->tx_name()<b->tx_name(); };
+        std::sort(abstract_rules.begin(), abstract_rules.end(), by_name);
+        std::sort(common_rules.begin(), common_rules.end(), by_name);
+
+        std::unordered_set<std::string> structs, abstract;
+        for (auto r: abstract_rules) abstract.insert(r->tx_name());
+        for (auto r: common_rules) structs.insert(r->tx_name());
+        structs.insert(abstract.begin(), abstract.end());
+
+        // objects of rules of imported grammars would only be found by tx_build
+        for (auto r: abstract_rules) {
+            for (auto &special: r->tx_inh_by()) {
+                if (structs.count(special)==0) {
+                    throw std::runtime_error("codegen: "+special+" of "+r->tx_name()+" is not a rule of the metamodel (imported grammars are not supported)");
+                }
+            }
+        }
+
+        std::vector<std::pair<const Rule*, std::vector<Field>>> fields;
+        for (auto r: common_rules) {
+            std::vector<Field> f;
+            for (auto &name: r->tx_attribute_names()) {
+                f.push_back(make_field(*r, name, r->get_attribute_info().at(name), structs, abstract));
+            }
+            fields.emplace_back(r, std::move(f));
+        }
+
+        std::ostringstream o;
+        o << "// generated by textx::codegen::generate_cpp (do not edit)\n";
+        o << "#pragma once\n";
+        o << "#include \"textx/codegen.h\"\n";
+        o << "#include <deque>\n";
+        o << "#include <memory>\n";
+        o << "#include <string>\n";
+        o << "#include <vector>\n";
+        o << "\n";
+        o << "namespace " << options.ns << " {\n\n";
+
+        std::vector<std::string> names{structs.begin(), structs.end()};
+        std::sort(names.begin(), names.end());
+        for (auto &n: names) {
+            o << "    struct " << n << ";\n";
+        }
+        o << "\n";
+
+        // common rules: plain structs tagged with their type (1, 2, ... in order of the names)
+        TypeTag tag = 0;
+        for (auto &[r, f]: fields) {
+            o << "    struct " << r->tx_name() << " : textx::codegen::GeneratedObject {\n";
+            o << "        static constexpr textx::codegen::TypeTag tx_tag = " << ++tag << ";\n";
+            for (auto &field: f) {
+                if (field.list) {
+                    o << "        std::vector<" << field.type << "> " << field.member << " = {};\n";
+                }
+                else {
+                    o << "        " << field.type << " " << field.member << " = " << field.init << ";\n";
+                }
+            }
+            o << "\n";
+            o << "        " << r->tx_name() << "() : textx::codegen::GeneratedObject{tx_tag} {}\n";
+            o << "    };\n\n";
+        }
+        // abstract rules: the tags of the common rules they are inherited by (see textx::codegen::Ptr)
+        for (auto r: abstract_rules) {
+            std::vector<std::string> specials;
+            for (auto &c: common_rules) {
+                if (r->tx_inh_by().count(c->tx_name())>0) specials.push_back(c->tx_name());
+            }
+            o << "    struct " << r->tx_name() << " {\n";
+            o << "        static constexpr bool tx_is(textx::codegen::TypeTag tag) {\n";
+            o << "            return ";
+            for (size_t i=0;i<specials.size();i++) {
+                o << (i>0 ? " || " : "") << "tag==" << specials[i] << "::tx_tag";
+            }
+            if (specials.empty()) o << "false";
+            o << ";\n";
+            o << "        }\n";
+            o << "    };\n\n";
+        }
+
+        auto main_rule = mm.tx_main_rule_name();
+        bool has_root = structs.count(main_rule)>0;
+        o << "    /** the generated objects of a model (see tx_build) */\n";
+        o << "    struct tx_model {\n";
+        o << "        std::shared_ptr<textx::Model> tx_source = nullptr; /// keeps the values of attributes with more than one type alive\n";
+        if (has_root) {
+            o << "        " << (abstract.count(main_rule)>0 ? "textx::codegen::Ptr<"+main_rule+">" : main_rule+"*") << " tx_root = nullptr;\n";
+        }
+        for (auto r: common_rules) {
+            o << "        std::deque<" << r->tx_name() << "> tx_" << r->tx_name() << " = {};\n";
+        }
+        o << "    };\n\n";
+
+        for (auto &[r, f]: fields) {
+            bool uses_index = std::any_of(f.begin(), f.end(), [](auto &field) { return field.uses_index; });
+            o << "    inline void tx_fill(" << r->tx_name() << "& o, const textx::object::Object& src, const textx::codegen::ObjectIndex&" << (uses_index ? " index" : "") << ") {\n";
+            for (auto &field: f) {
+                if (field.list) {
+                    o << "        for (auto& v: src[\"" << field.attr << "\"]) o." << field.member << ".push_back(" << call(field, "v") << ");\n";
+                }
+                else {
+                    o << "        o." << field.member << " = " << call(field, "src[\""+field.attr+"\"]") << ";\n";
+                }
+            }
+            o << "    }\n\n";
+        }
+
+        o << "    /** create the structs of all objects of a model (the source model must not be modified afterwards) */\n";
+        o << "    inline std::unique_ptr<tx_model> tx_build(std::shared_ptr<textx::Model> source) {\n";
+        o << "        auto res = std::make_unique<tx_model>();\n";
+        o << "        res->tx_source = source;\n";
+        o << "        textx::codegen::ObjectIndex index;\n";
+        for (auto r: common_rules) {
+            o << "        std::vector<const textx::object::Object*> src_" << r->tx_name() << ";\n";
+        }
+        o << "        textx::object::traverse(source->val(), [&](textx::object::Value& v) {\n";
+        o << "            if (!v.is_pure_obj() || v.is_null()) return;\n";
+        o << "            auto& obj = *v.obj();\n";
+        o << "            ";
+        for (auto r: common_rules) {
+            auto &n = r->tx_name();
+            o << "if (obj.type==\"" << n << "\") {\n";
+            o << "                index[&obj] = &res->tx_" << n << ".emplace_back();\n";
+            o << "                src_" << n << ".push_back(&obj);\n";
+            o << "            }\n";
+            o << "            else ";
+        }
+        o << "throw std::runtime_error(\"unexpected type \"+obj.type);\n";
+        o << "        });\n";
+        for (auto r: common_rules) {
+            auto &n = r->tx_name();
+            o << "        for (size_t i=0; i<src_" << n << ".size(); i++) tx_fill(res->tx_" << n << "[i], *src_" << n << "[i], index);\n";
+        }
+        if (has_root) {
+            o << "        res->tx_root = textx::codegen::get_obj<" << main_rule << ">(source->val(), index);\n";
+        }
+        o << "        return res;\n";
+        o << "    }\n";
+        o << "}\n";
+        return o.str();
+    }
+}
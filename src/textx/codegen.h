@@ -0,0 +1,103 @@
+#pragma once
+
+#include "textx/metamodel.h"
+#include "textx/model.h"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+/**
+ * Generation of plain C++ structs from a metamodel.
+ *
+ * generate_cpp creates a header with one plain struct per common rule (w/o
+ * virtual functions, tagged with its type, see GeneratedObject), typed fields,
+ * std::vector lists and pointers for object attributes, and a builder
+ * (tx_build) which fills the structs from a model. Abstract rules only define
+ * which tags they accept; attributes of an abstract type are Ptr<Rule>.
+ * The functions below are used by the generated code.
+ */
+namespace textx::codegen {
+
+    struct Options {
+        std::string ns = "model"; /// namespace of the generated code
+    };
+
+    /** the C++ header for the rules of mm (throws for rules of imported/referenced metamodels) */
+    std::string generate_cpp(const textx::Metamodel& mm, const Options& options={});
+
+    using TypeTag = std::uint32_t;
+
+    /** common (non-virtual) base of all generated structs: the tx_tag of the struct */
+    struct GeneratedObject {
+        TypeTag tx_type = 0;
+    };
+
+    /** pointer to the struct of one of the rules an abstract rule T is inherited by (see T::tx_is) */
+    template<class T>
+    struct Ptr {
+        GeneratedObject* ptr = nullptr;
+
+        Ptr() = default;
+        Ptr(std::nullptr_t) {}
+        explicit Ptr(GeneratedObject* p) : ptr{p} {}
+        /** the object as struct S (nullptr if it is another type) */
+        template<class S>
+        S* as() const { return (ptr!=nullptr && ptr->tx_type==S::tx_tag) ? static_cast<S*>(ptr) : nullptr; }
+        GeneratedObject* get() const { return ptr; }
+        TypeTag tx_type() const { return ptr==nullptr ? 0 : ptr->tx_type; }
+        explicit operator bool() const { return ptr!=nullptr; }
+        bool operator==(const Ptr&) const = default;
+    };
+
+    /** the generated struct of each object of a model */
+    using ObjectIndex = std::unordered_map<const textx::object::Object*, GeneratedObject*>;
+
+    /** T* for common rules (and GeneratedObject), Ptr<T> for abstract rules */
+    template<class T, class V>
+    auto get_obj(const V& v, const ObjectIndex& index) {
+        GeneratedObject* res = nullptr;
+        if (!v.is_null()) {
+            auto obj = v.obj();
+            auto p = index.find(obj.get());
+            if (p==index.end()) {
+                throw std::runtime_error(std::string("object of type ")+obj->type+" is not part of the model (e.g., imported)");
+            }
+            res = p->second;
+        }
+        if constexpr (std::is_same_v<T, GeneratedObject>) {
+            return res;
+        }
+        else if constexpr (requires { T::tx_tag; }) {
+            TEXTX_ASSERT(res==nullptr || res->tx_type==T::tx_tag, "unexpected type of a generated object");
+            return static_cast<T*>(res);
+        }
+        else {
+            TEXTX_ASSERT(res==nullptr || T::tx_is(res->tx_type), "unexpected type of a generated object");
+            return Ptr<T>{res};
+        }
+    }
+
+    template<class V>
+    std::string get_str(const V& v) { return v.str(); }
+
+    template<class V>
+    long long get_int(const V& v) { return v.str_view().empty() ? 0 : v.i(); } // empty: optional attribute
+
+    template<class V>
+    double get_float(const V& v) { return v.str_view().empty() ? 0 : static_cast<double>(v.f()); }
+
+    template<class V>
+    bool get_bool(const V& v) {
+        if (v.is_boolean()) return v.boolean();
+        return !v.str_view().empty() && v.boolean(); // BOOL (empty: optional attribute)
+    }
+
+    /** values of attributes with more than one possible type are not converted */
+    inline const textx::object::Value* get_value(const textx::object::Value& v) { return &v; }
+    inline const textx::object::Value* get_value(const textx::object::AttributeValue& v) {
+        TEXTX_ASSERT(!v.is_list());
+        return &std::get<textx::object::Value>(v.data);
+    }
+}
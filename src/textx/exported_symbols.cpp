@@ -0,0 +1,137 @@
+#include "textx/exported_symbols.h"
+#include "textx/model.h"
+#include <mutex>
+#include <unordered_set>
+
+namespace textx {
+
+    void ExportedSymbols::add(const std::shared_ptr<textx::Model>& m) {
+        TEXTX_ASSERT(m!=nullptr);
+        std::unique_lock lock{mutex};
+        auto [p, inserted] = models.try_emplace(m.get(), Known{m});
+        if (!inserted && !p->second.indexed) return; // still pending
+        if (!inserted) {
+            erase_entries(m.get());
+            p->second = Known{m};
+        }
+        n_pending++;
+    }
+
+    void ExportedSymbols::update(const std::shared_ptr<textx::Model>& m) {
+        if (contains(m.get())) add(m);
+    }
+
+    void ExportedSymbols::remove(const textx::Model* m) {
+        std::unique_lock lock{mutex};
+        auto p = models.find(m);
+        if (p==models.end()) return;
+        if (p->second.indexed) erase_entries(m);
+        else n_pending--;
+        models.erase(p);
+    }
+
+    bool ExportedSymbols::contains(const textx::Model* m) const {
+        std::shared_lock lock{mutex};
+        return models.count(m)>0;
+    }
+
+    size_t ExportedSymbols::size() const {
+        std::shared_lock lock{mutex};
+        return models.size();
+    }
+
+    std::shared_ptr<textx::object::Object> ExportedSymbols::find_name(std::string_view name, const std::vector<std::weak_ptr<textx::Model>>& imports, const Search& direct_search) {
+        return find(names, name, imports, direct_search);
+    }
+
+    std::shared_ptr<textx::object::Object> ExportedSymbols::find_fqn(std::string_view fqn, const std::vector<std::weak_ptr<textx::Model>>& imports, const Search& direct_search) {
+        return find(fqns, fqn, imports, direct_search);
+    }
+
+    std::shared_ptr<textx::object::Object> ExportedSymbols::find(const Table& table, std::string_view name, const std::vector<std::weak_ptr<textx::Model>>& imports, const Search& direct_search) {
+        std::shared_lock lock{mutex};
+        while (n_pending>0) {
+            lock.unlock();
+            {
+                std::unique_lock exclusive{mutex};
+                index_pending();
+            }
+            lock.lock();
+        }
+        auto p = table.find(name);
+        for (auto &weak_im: imports) {
+            auto im = weak_im.lock();
+            TEXTX_ASSERT(im!=nullptr);
+            if (models.count(im.get())>0) {
+                if (p==table.end()) continue;
+                for (auto &entry: p->second) {
+                    if (entry.model==im.get()) return entry.obj.lock();
+                }
+            }
+            else if (auto res = direct_search(*im)) {
+                return res;
+            }
+        }
+        return nullptr;
+    }
+
+    void ExportedSymbols::index_pending() {
+        for (auto &[ptr, known]: models) {
+            if (known.indexed) continue;
+            auto m = known.model.lock();
+            TEXTX_ASSERT(m!=nullptr, "model of the workspace expired");
+            index(*m);
+            known.indexed = true;
+            n_pending--;
+        }
+    }
+
+    void ExportedSymbols::index(textx::Model& m) {
+        // plain names: first object in traversal order
+        std::unordered_set<std::string_view> seen;
+        for (auto p=textx::object::objects(m.val()).begin(); p!=std::default_sentinel; ++p) {
+            auto obj = p.value().obj();
+            if (!obj->has_attr("name")) continue;
+            auto &attr = (*obj)["name"];
+            if (attr.is_str() && seen.insert(attr.str_view()).second) {
+                names[attr.str()].push_back({&m, obj});
+            }
+        }
+        if (!m.val().is_obj() || m.val().is_null()) return;
+
+        // dot separated names: depth first in attribute order, i.e., the first
+        // match of dot_separated_name_search (parts never contain dots)
+        std::unordered_set<std::string> seen_fqns;
+        std::string fqn;
+        std::vector<size_t> prefix_sizes; // size of fqn for the object at each depth (only named objects are entered)
+        for (auto p=textx::object::objects(m.val()).begin(); p!=std::default_sentinel; ++p) {
+            if (p.depth()==0) { // the model root
+                prefix_sizes = {0};
+                continue;
+            }
+            fqn.resize(prefix_sizes[p.depth()-1]);
+            prefix_sizes.resize(p.depth());
+            auto name = (p->has_attr("name") && (*p)["name"].is_str()) ? (*p)["name"].str_view() : std::string_view{};
+            if (name.empty() || name.find('.')!=name.npos) {
+                p.skip_children();
+                continue;
+            }
+            if (fqn.size()>0) fqn += '.';
+            fqn += name;
+            if (seen_fqns.insert(fqn).second) {
+                fqns[fqn].push_back({&m, p.value().obj()});
+            }
+            prefix_sizes.push_back(fqn.size());
+        }
+    }
+
+    void ExportedSymbols::erase_entries(const textx::Model* m) {
+        for (auto *table: {&names, &fqns}) {
+            for (auto p=table->begin(); p!=table->end();) {
+                std::erase_if(p->second, [&](auto &entry) { return entry.model==m; });
+                if (p->second.empty()) p = table->erase(p);
+                else ++p;
+            }
+        }
+    }
+}
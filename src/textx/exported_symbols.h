@@ -0,0 +1,74 @@
+#pragma once
+
+#include "textx/object.h"
+#include "textx/utils.h"
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace textx {
+    class Model;
+}
+
+/**
+ * Names exported by the known models of a workspace (see Workspace::tx_exported_symbols).
+ *
+ * Each model is indexed once (on the first lookup after it was added), no
+ * matter how many models import it: the first object with a name in traversal
+ * order (see Model::objects_named) and the first object of each dot separated
+ * name of named children (see scoping::dot_separated_name_search, top-level
+ * names included). A lookup for an importing model is a single hash probe plus
+ * a scan of the (few) models exporting the name in import order. Models which
+ * are unknown to the workspace (e.g., builtin models) are searched directly.
+ */
+namespace textx {
+
+    class ExportedSymbols {
+    public:
+        using Search = std::function<std::shared_ptr<textx::object::Object>(textx::Model&)>;
+
+        /** adds (or re-indexes) a model; the index is built on the next lookup */
+        void add(const std::shared_ptr<textx::Model>& m);
+        /** re-indexes a known model (see Model::reset_type_index); unknown models are ignored */
+        void update(const std::shared_ptr<textx::Model>& m);
+        void remove(const textx::Model* m);
+        bool contains(const textx::Model* m) const;
+        /** number of known models */
+        size_t size() const;
+
+        /**
+         * the first object named name (w/o type check) of the first model of
+         * imports having one; direct_search is called for the models unknown
+         * to the table.
+         */
+        std::shared_ptr<textx::object::Object> find_name(std::string_view name, const std::vector<std::weak_ptr<textx::Model>>& imports, const Search& direct_search);
+        /** like find_name for a dot separated name below the model roots */
+        std::shared_ptr<textx::object::Object> find_fqn(std::string_view fqn, const std::vector<std::weak_ptr<textx::Model>>& imports, const Search& direct_search);
+
+    private:
+        struct Entry {
+            const textx::Model* model;
+            textx::object::Link<textx::object::Object> obj;
+        };
+        using Table = std::unordered_map<std::string, std::vector<Entry>, textx::utils::string_hash, std::equal_to<>>;
+        struct Known {
+            std::weak_ptr<textx::Model> model;
+            bool indexed = false;
+        };
+
+        std::shared_ptr<textx::object::Object> find(const Table& table, std::string_view name, const std::vector<std::weak_ptr<textx::Model>>& imports, const Search& direct_search);
+        void index_pending();   // (mutex must be locked exclusively)
+        void index(textx::Model& m);
+        void erase_entries(const textx::Model* m);
+
+        mutable std::shared_mutex mutex;
+        std::unordered_map<const textx::Model*, Known> models = {};
+        size_t n_pending = 0;
+        Table names = {};
+        Table fqns = {};
+    };
+}
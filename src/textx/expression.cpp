@@ -0,0 +1,394 @@
+#include "textx/expression.h"
+#include "textx/rule.h"
+#include "textx/metamodel.h"
+#include "textx/assert.h"
+#include <deque>
+
+namespace {
+    namespace te = textx::expression;
+    namespace ta = textx::arpeggio;
+    using ET = textx::expression::ExpressionType;
+
+    te::Expression make(ET type, std::vector<te::Expression> children={}, std::string text="") {
+        te::Expression e;
+        e.type = type;
+        e.children = std::move(children);
+        e.text = std::move(text);
+        return e;
+    }
+
+    // children of these nodes must not change their type (see expression.h)
+    bool children_keep_type(const te::Expression& e) {
+        return e.type==ET::named || e.type==ET::unordered_group;
+    }
+
+    void flatten_impl(te::Expression& e, bool keep_type) {
+        for (auto& c: e.children) {
+            flatten_impl(c, children_keep_type(e));
+        }
+        if (e.type==ET::sequence || e.type==ET::ordered_choice) {
+            std::vector<te::Expression> flat;
+            for (auto& c: e.children) {
+                if (c.type==e.type) {
+                    for (auto& cc: c.children) flat.push_back(std::move(cc));
+                }
+                else {
+                    flat.push_back(std::move(c));
+                }
+            }
+            e.children = std::move(flat);
+            if (!keep_type && e.children.size()==1) {
+                te::Expression c = std::move(e.children[0]);
+                e = std::move(c);
+            }
+        }
+    }
+
+    std::vector<te::Expression> elements_of(const te::Expression& alternative) {
+        if (alternative.type==ET::sequence) return alternative.children;
+        return {alternative};
+    }
+
+    void hoist_impl(te::Expression& e, bool keep_type) {
+        for (auto& c: e.children) {
+            hoist_impl(c, children_keep_type(e));
+        }
+        if (e.type!=ET::ordered_choice) return;
+
+        auto& alternatives = e.children;
+        std::vector<te::Expression> new_alternatives;
+        size_t i=0;
+        while (i<alternatives.size()) {
+            auto first = elements_of(alternatives[i]);
+            size_t j=i+1;
+            if (!first.empty()) {
+                while (j<alternatives.size()) {
+                    auto other = elements_of(alternatives[j]);
+                    if (other.empty() || !(other[0]==first[0])) break;
+                    j++;
+                }
+            }
+            if (j-i>=2) {
+                std::vector<te::Expression> rests;
+                for (size_t k=i;k<j;k++) {
+                    auto rest = elements_of(alternatives[k]);
+                    rest.erase(rest.begin());
+                    if (rest.size()==1) rests.push_back(std::move(rest[0]));
+                    else rests.push_back(te::sequence(std::move(rest)));
+                }
+                auto inner = te::ordered_choice(std::move(rests));
+                hoist_impl(inner, false);
+                new_alternatives.push_back(te::sequence({std::move(first[0]), std::move(inner)}));
+            }
+            else {
+                new_alternatives.push_back(std::move(alternatives[i]));
+            }
+            i=j;
+        }
+        e.children = std::move(new_alternatives);
+        if (e.children.size()==1 && !keep_type) {
+            te::Expression c = std::move(e.children[0]);
+            e = std::move(c);
+        }
+    }
+
+    void reduce_memoization_impl(te::Expression& e, bool in_unordered_group) {
+        bool is_rule = e.type==ET::named && e.text.starts_with("rule://") && e.memoize;
+        if (in_unordered_group) {
+            e.memoize = (e.type!=ET::named && e.type!=ET::eolterm && e.type!=ET::rule_ref) || e.memoize;
+        }
+        else if (!is_rule) {
+            e.memoize = false;
+        }
+        size_t n = e.children.size();
+        for (size_t i=0;i<n;i++) {
+            bool is_separator = e.has_separator && i+1==n;
+            reduce_memoization_impl(e.children[i], e.type==ET::unordered_group && !is_separator);
+        }
+    }
+
+    void collect_rule_refs(const te::Expression& e, std::vector<std::string>& res) {
+        if (e.type==ET::rule_ref) res.push_back(e.text);
+        for (auto& c: e.children) collect_rule_refs(c, res);
+    }
+
+    bool has_rule_refs(const te::Expression& e) {
+        std::vector<std::string> res;
+        collect_rule_refs(e, res);
+        return !res.empty();
+    }
+
+    ta::Pattern wrap(const te::Expression& e, ta::Pattern p) {
+        return e.memoize ? ta::rule(p) : ta::skip(p);
+    }
+
+    std::vector<ta::Pattern> to_patterns(const std::vector<te::Expression>& v, textx::Metamodel& mm) {
+        std::vector<ta::Pattern> res;
+        res.reserve(v.size());
+        for (auto& e: v) res.push_back(te::to_pattern(e, mm));
+        return res;
+    }
+}
+
+namespace textx::expression {
+
+    Expression str_match(std::string s) { return make(ET::str_match, {}, std::move(s)); }
+    Expression str_choice(std::vector<std::string> literals) {
+        auto e = make(ET::str_choice);
+        e.literals = std::move(literals);
+        return e;
+    }
+    Expression regex_match(std::string s, bool capture) {
+        auto e = make(ET::regex_match, {}, std::move(s));
+        e.capture = capture;
+        return e;
+    }
+    Expression sequence(std::vector<Expression> children) { return make(ET::sequence, std::move(children)); }
+    Expression ordered_choice(std::vector<Expression> children) { return make(ET::ordered_choice, std::move(children)); }
+    Expression unordered_group(std::vector<Expression> children, std::optional<Expression> separator) {
+        auto e = make(ET::unordered_group, std::move(children));
+        if (separator.has_value()) {
+            e.children.push_back(std::move(separator.value()));
+            e.has_separator = true;
+        }
+        return e;
+    }
+    Expression negative_lookahead(Expression e) { return make(ET::negative_lookahead, {std::move(e)}); }
+    Expression positive_lookahead(Expression e) { return make(ET::positive_lookahead, {std::move(e)}); }
+    Expression one_or_more(Expression e) { return make(ET::one_or_more, {std::move(e)}); }
+    Expression zero_or_more(Expression e) { return make(ET::zero_or_more, {std::move(e)}); }
+    Expression optional(Expression e) { return make(ET::optional, {std::move(e)}); }
+    Expression eolterm(Expression e) { return make(ET::eolterm, {std::move(e)}); }
+    Expression rule_ref(std::string name) { return make(ET::rule_ref, {}, std::move(name)); }
+    Expression named(std::string name, Expression e, bool memoize) {
+        auto res = make(ET::named, {std::move(e)}, std::move(name));
+        res.memoize = memoize;
+        return res;
+    }
+
+    bool Expression::operator==(const Expression& other) const {
+        return type==other.type && text==other.text && literals==other.literals
+            && capture==other.capture && has_separator==other.has_separator
+            && children==other.children;
+    }
+
+    size_t Expression::size() const {
+        size_t n=1;
+        for (auto& c: children) n += c.size();
+        return n;
+    }
+
+    bool Expression::can_fail() const {
+        switch(type) {
+            case ET::optional:
+            case ET::zero_or_more:
+                return false;
+            case ET::named:
+            case ET::eolterm:
+                return children[0].can_fail();
+            case ET::sequence:
+                return std::any_of(children.begin(), children.end(), [](auto &c) { return c.can_fail(); });
+            case ET::ordered_choice:
+                return std::all_of(children.begin(), children.end(), [](auto &c) { return c.can_fail(); });
+            default:
+                return true;
+        }
+    }
+
+    void Expression::print(std::ostream &o) const {
+        if (memoize && type!=ET::rule_ref && type!=ET::eolterm) o << "@";
+        auto print_children = [&](const char* sep) {
+            for (size_t i=0;i<children.size();i++) {
+                if (i>0) o << sep;
+                children[i].print(o);
+            }
+        };
+        switch(type) {
+            case ET::str_match: o << "'" << text << "'"; break;
+            case ET::str_choice:
+                o << "lits(";
+                for (size_t i=0;i<literals.size();i++) {
+                    if (i>0) o << "|";
+                    o << "'" << literals[i] << "'";
+                }
+                o << ")";
+                break;
+            case ET::regex_match: o << (capture?"capture(/":"/") << text << (capture?"/)":"/"); break;
+            case ET::sequence: o << "seq("; print_children(" "); o << ")"; break;
+            case ET::ordered_choice: o << "choice("; print_children(" | "); o << ")"; break;
+            case ET::unordered_group: o << (has_separator?"group_sep(":"group("); print_children(" "); o << ")"; break;
+            case ET::negative_lookahead: o << "!("; print_children(" "); o << ")"; break;
+            case ET::positive_lookahead: o << "&("; print_children(" "); o << ")"; break;
+            case ET::one_or_more: o << "("; print_children(" "); o << ")+"; break;
+            case ET::zero_or_more: o << "("; print_children(" "); o << ")*"; break;
+            case ET::optional: o << "("; print_children(" "); o << ")?"; break;
+            case ET::eolterm: o << "eolterm("; print_children(" "); o << ")"; break;
+            case ET::rule_ref: o << (target?"ref*(":"ref(") << text << ")"; break;
+            case ET::named: o << "named(" << text << ", "; print_children(" "); o << ")"; break;
+        }
+    }
+
+    void resolve_rule_refs(Expression& e, const RuleLookup& lookup) {
+        if (e.type==ET::rule_ref && e.target==nullptr) {
+            e.target = lookup(e.text);
+        }
+        for (auto& c: e.children) resolve_rule_refs(c, lookup);
+    }
+
+    void inline_trivial_rules(Expression& e) {
+        if (e.type==ET::rule_ref && e.target!=nullptr) {
+            auto &target = *e.target;
+            auto &body = target.tx_expression();
+            bool trivial = body.type==ET::named
+                && target.tx_params().count("skipws")==0
+                && target.tx_params().count("noskipws")==0
+                && body.size()<=8
+                && !has_rule_refs(body);
+            if (trivial) {
+                e = body;
+            }
+            return;
+        }
+        for (auto& c: e.children) inline_trivial_rules(c);
+    }
+
+    void flatten(Expression& e) {
+        flatten_impl(e, true);
+    }
+
+    void merge_literals(Expression& e) {
+        for (auto& c: e.children) merge_literals(c);
+        if (e.type!=ET::ordered_choice) return;
+        std::vector<Expression> merged;
+        std::vector<std::string> run;
+        auto finish_run = [&]() {
+            if (run.size()==1) merged.push_back(te::str_match(run[0]));
+            else if (run.size()>1) merged.push_back(te::str_choice(run));
+            run.clear();
+        };
+        for (auto& c: e.children) {
+            if (c.type==ET::str_match) run.push_back(c.text);
+            else if (c.type==ET::str_choice) run.insert(run.end(), c.literals.begin(), c.literals.end());
+            else {
+                finish_run();
+                merged.push_back(std::move(c));
+            }
+        }
+        finish_run();
+        if (merged.size()==1 && merged[0].type==ET::str_choice) {
+            // same match type as the original choice
+            Expression c = std::move(merged[0]);
+            e = std::move(c);
+        }
+        else {
+            e.children = std::move(merged);
+        }
+    }
+
+    void hoist_common_prefixes(Expression& e) {
+        hoist_impl(e, true);
+    }
+
+    void remove_unreachable_alternatives(Expression& e) {
+        for (auto& c: e.children) remove_unreachable_alternatives(c);
+        if (e.type!=ET::ordered_choice) return;
+        auto it = std::find_if(e.children.begin(), e.children.end(), [](auto& c) { return !c.can_fail(); });
+        if (it!=e.children.end()) {
+            e.children.erase(it+1, e.children.end());
+        }
+    }
+
+    void reduce_memoization(Expression& e) {
+        reduce_memoization_impl(e, false);
+    }
+
+    std::unordered_set<std::string> remove_unreachable_rules(std::unordered_map<std::string, Expression>& rules, const std::vector<std::string>& roots) {
+        std::unordered_set<std::string> reachable;
+        std::deque<std::string> todo(roots.begin(), roots.end());
+        while (!todo.empty()) {
+            auto name = todo.front();
+            todo.pop_front();
+            auto it = rules.find(name);
+            if (it==rules.end() || reachable.count(name)>0) continue;
+            reachable.insert(name);
+            std::vector<std::string> refs;
+            collect_rule_refs(it->second, refs);
+            todo.insert(todo.end(), refs.begin(), refs.end());
+        }
+        std::unordered_set<std::string> removed;
+        for (auto it=rules.begin(); it!=rules.end();) {
+            if (reachable.count(it->first)==0) {
+                removed.insert(it->first);
+                it = rules.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+        return removed;
+    }
+
+    void optimize(Expression& e, const RuleLookup& lookup, std::ostream* trace) {
+        std::vector<std::pair<const char*, std::function<void(Expression&)>>> passes = {
+            {"resolve_rule_refs", [&](Expression& x) { resolve_rule_refs(x, lookup); }},
+            {"inline_trivial_rules", inline_trivial_rules},
+            {"remove_unreachable_alternatives", remove_unreachable_alternatives},
+            {"flatten", flatten},
+            {"merge_literals", merge_literals},
+            {"hoist_common_prefixes", hoist_common_prefixes},
+            {"flatten", flatten},
+            {"reduce_memoization", reduce_memoization},
+        };
+        for (auto& [name, pass]: passes) {
+            if (trace) {
+                (*trace) << "[" << name << "]\n  before: " << e << "\n";
+            }
+            pass(e);
+            if (trace) {
+                (*trace) << "  after:  " << e << "\n";
+            }
+        }
+    }
+
+    textx::arpeggio::Pattern to_pattern(const Expression& e, textx::Metamodel& mm) {
+        switch(e.type) {
+            case ET::str_match: return wrap(e, ta::raw::str_match(e.text));
+            case ET::str_choice: return wrap(e, ta::raw::str_choice(e.literals));
+            case ET::regex_match: {
+                auto p = wrap(e, ta::raw::regex_match(e.text));
+                return e.capture ? ta::capture(p) : p;
+            }
+            case ET::sequence: return wrap(e, ta::raw::sequence(to_patterns(e.children, mm)));
+            case ET::ordered_choice: return wrap(e, ta::raw::ordered_choice(to_patterns(e.children, mm)));
+            case ET::unordered_group: {
+                auto patterns = to_patterns(e.children, mm);
+                std::optional<ta::Pattern> separator = std::nullopt;
+                if (e.has_separator) {
+                    separator = patterns.back();
+                    patterns.pop_back();
+                }
+                return wrap(e, ta::raw::unordered_group(patterns, separator));
+            }
+            case ET::negative_lookahead: return wrap(e, ta::raw::negative_lookahead(to_pattern(e.children[0], mm)));
+            case ET::positive_lookahead: return wrap(e, ta::raw::positive_lookahead(to_pattern(e.children[0], mm)));
+            case ET::one_or_more: return wrap(e, ta::raw::one_or_more(to_pattern(e.children[0], mm)));
+            case ET::zero_or_more: return wrap(e, ta::raw::zero_or_more(to_pattern(e.children[0], mm)));
+            case ET::optional: return wrap(e, ta::raw::optional(to_pattern(e.children[0], mm)));
+            case ET::eolterm: return ta::eolterm(to_pattern(e.children[0], mm));
+            case ET::rule_ref: {
+                if (e.target!=nullptr) {
+                    const textx::Rule* target = e.target;
+                    return [target](const ta::Config &config, ta::ParserState &text, ta::TextPosition pos) -> std::optional<ta::Match> {
+                        return (*target)(config, text, pos);
+                    };
+                }
+                return mm.ref(e.text);
+            }
+            case ET::named: {
+                auto p = ta::named(e.text, to_pattern(e.children[0], mm));
+                return e.memoize ? ta::rule(p) : p;
+            }
+        }
+        throw std::runtime_error("unexpected expression type");
+    }
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "textx/arpeggio.h"
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <ostream>
+
+namespace textx {
+    class Rule;
+    class Metamodel;
+}
+
+/**
+ * Intermediate representation of compiled grammar rules.
+ *
+ * The rule compiler (rule.cpp) translates the textX parse tree of a rule into
+ * an Expression tree. The optimizer passes below rewrite this tree and
+ * to_pattern() finally lowers it to textx::arpeggio::Pattern objects.
+ *
+ * All passes preserve the structure relevant for model creation: the direct
+ * child of a "named" node and the elements of an unordered group keep their
+ * type (e.g., "assignment://x" is always evaluated on its first child).
+ */
+namespace textx::expression {
+
+    enum class ExpressionType {
+        str_match,
+        str_choice,         /// ordered choice of string literals (see merge_literals)
+        regex_match,
+        sequence,
+        ordered_choice,
+        unordered_group,    /// last child is the separator if has_separator is set
+        negative_lookahead,
+        positive_lookahead,
+        one_or_more,
+        zero_or_more,
+        optional,
+        eolterm,
+        rule_ref,           /// text = rule name
+        named,              /// text = match name ("rule://...", "assignment://...", ...)
+    };
+
+    struct Expression {
+        ExpressionType type = ExpressionType::sequence;
+        std::string text = "";
+        std::vector<std::string> literals = {};
+        std::vector<Expression> children = {};
+        bool capture = false;       /// regex_match: capture the matched text
+        bool has_separator = false; /// unordered_group: last child is a separator
+        bool memoize = true;        /// wrap with arpeggio::rule() (else arpeggio::skip())
+        const textx::Rule* target = nullptr; /// rule_ref: resolved rule (see resolve_rule_refs)
+
+        bool operator==(const Expression& other) const;
+        size_t size() const;
+        bool can_fail() const;
+        void print(std::ostream &o) const;
+        friend inline std::ostream& operator<<(std::ostream &o, const Expression &e) {
+            e.print(o);
+            return o;
+        }
+    };
+
+    Expression str_match(std::string s);
+    Expression str_choice(std::vector<std::string> literals);
+    Expression regex_match(std::string s, bool capture=false);
+    Expression sequence(std::vector<Expression> children);
+    Expression ordered_choice(std::vector<Expression> children);
+    Expression unordered_group(std::vector<Expression> children, std::optional<Expression> separator=std::nullopt);
+    Expression negative_lookahead(Expression e);
+    Expression positive_lookahead(Expression e);
+    Expression one_or_more(Expression e);
+    Expression zero_or_more(Expression e);
+    Expression optional(Expression e);
+    Expression eolterm(Expression e);
+    Expression rule_ref(std::string name);
+    Expression named(std::string name, Expression e, bool memoize=false);
+
+    using RuleLookup = std::function<const textx::Rule*(const std::string&)>;
+
+    // optimizer passes:
+
+    /** set the target of all rule references (direct call instead of a lookup by name during parsing) */
+    void resolve_rule_refs(Expression& e, const RuleLookup& lookup);
+    /** replace references to small rules without references (e.g. ID, INT) by a copy of the rule */
+    void inline_trivial_rules(Expression& e);
+    /** flatten nested sequences/choices and remove sequences/choices with one element */
+    void flatten(Expression& e);
+    /** merge adjacent string literal alternatives of a choice into one str_choice */
+    void merge_literals(Expression& e);
+    /** a b | a c  -->  a (b | c) */
+    void hoist_common_prefixes(Expression& e);
+    /** remove alternatives following an alternative which cannot fail (e.g., "a? | b") */
+    void remove_unreachable_alternatives(Expression& e);
+    /** memoize only rules and elements of unordered groups (the latter are retried at the same position) */
+    void reduce_memoization(Expression& e);
+    /** remove all rules not reachable from the given roots; returns the names of the removed rules */
+    std::unordered_set<std::string> remove_unreachable_rules(std::unordered_map<std::string, Expression>& rules, const std::vector<std::string>& roots);
+
+    /**
+     * run all passes applicable to a single rule.
+     * If trace is given, the expression is dumped before and after each pass.
+     */
+    void optimize(Expression& e, const RuleLookup& lookup, std::ostream* trace=nullptr);
+
+    /** create the parser for an expression (unresolved rule references are looked up in mm) */
+    textx::arpeggio::Pattern to_pattern(const Expression& e, textx::Metamodel& mm);
+}
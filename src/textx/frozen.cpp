@@ -0,0 +1,140 @@
+#include "textx/frozen.h"
+#include "textx/metamodel.h"
+#include "textx/model.h"
+#include <unordered_map>
+#include <unordered_set>
+
+namespace textx::frozen {
+
+    std::shared_ptr<const FrozenModel> FrozenModel::create(const std::shared_ptr<textx::Model>& m) {
+        std::shared_ptr<FrozenModel> res{new FrozenModel{}};
+        res->mm = m->tx_metamodel();
+        TEXTX_ASSERT(res->mm!=nullptr);
+        TEXTX_ASSERT(m->val().is_pure_obj() && !m->val().is_null(), "only models with a root object can be frozen");
+
+        std::vector<std::shared_ptr<textx::Model>> models = { m };
+        for (size_t i=0;i<models.size();i++) {
+            for (auto &weak_other: models[i]->tx_imported_models()) {
+                auto other = weak_other.lock();
+                TEXTX_ASSERT(other != nullptr);
+                if (std::find(models.begin(), models.end(), other)==models.end()) {
+                    models.push_back(other);
+                }
+            }
+        }
+
+        // 1) number the objects and count the attributes/values (the storage is allocated once)
+        std::unordered_map<const textx::object::Object*, size_t> index;
+        size_t n_attributes = 0, n_values = 0;
+        for (auto &model: models) {
+            for (auto &obj: textx::object::objects(model->val())) {
+                index.emplace(&obj, index.size());
+                n_attributes += obj.attributes.size();
+                for (auto &[name, av]: obj.attributes) {
+                    n_values += av.is_list() ? std::get<std::vector<textx::object::Value>>(av.data).size() : 1;
+                }
+            }
+            if (model==m) res->m_own_object_count = index.size();
+            res->texts.push_back(model->model_text);
+            res->strings.push_back(model->model_strings);
+        }
+        res->all_objects.resize(index.size());
+        res->all_attributes.reserve(n_attributes);
+        res->all_values.reserve(n_values);
+
+        std::unordered_set<const textx::object::AttributeLayout*> known_layouts;
+        auto frozen_object = [&](const textx::object::Object* obj) -> const FrozenObject* {
+            if (obj==nullptr) return nullptr;
+            auto p = index.find(obj);
+            return (p==index.end()) ? nullptr : &res->all_objects[p->second]; // e.g. object of a model not imported
+        };
+        auto freeze_value = [&](const textx::object::Value& v) {
+            auto &fv = res->all_values.emplace_back();
+            fv.m_pos = v.pos;
+            if (v.is_str()) {
+                auto &text = std::get<textx::object::MatchText>(v.data);
+                fv.kind = FrozenValue::Kind::str;
+                fv.text = text.owns_text ? std::string_view{res->copied_texts.emplace_back(text.text())} : text.text();
+                fv.number = text.is_number();
+                fv.scalar = text.scalar;
+                switch (text.scalar) {
+                    case textx::object::Scalar::integer: fv.int_value = text.int_value; break;
+                    case textx::object::Scalar::floating: fv.float_value = text.float_value; break;
+                    case textx::object::Scalar::boolean: fv.boolean_value = text.bool_value; break;
+                    case textx::object::Scalar::none: break;
+                }
+            }
+            else if (v.is_boolean()) {
+                fv.kind = FrozenValue::Kind::boolean;
+                fv.boolean_value = v.boolean();
+            }
+            else if (v.is_ref()) {
+                fv.kind = FrozenValue::Kind::ref;
+                fv.object = frozen_object(v.ref().target().get());
+            }
+            else if (v.is_pure_obj()) {
+                fv.kind = FrozenValue::Kind::obj;
+                fv.object = frozen_object(std::get<std::shared_ptr<textx::object::Object>>(v.data).get());
+            }
+        };
+
+        // 2) copy (same order as in 1)
+        for (auto &model: models) {
+            auto model_mm = model->tx_metamodel();
+            for (auto &obj: textx::object::objects(model->val())) {
+                auto &fo = res->all_objects[index.at(&obj)];
+                fo.m_type = textx::object::intern(obj.type);
+                fo.m_type_id = (model_mm==res->mm || res->mm->has_rule(obj.type, true)) ? res->mm->type_id(obj) : 0;
+                fo.m_parent = frozen_object(obj.parent().get());
+                fo.m_pos = obj.pos;
+                auto &layout = obj.attributes.layout();
+                fo.layout = layout.get();
+                if (known_layouts.insert(layout.get()).second) {
+                    res->layouts.push_back(layout);
+                }
+                fo.attributes = res->all_attributes.data()+res->all_attributes.size();
+                for (auto &[name, av]: obj.attributes) {
+                    auto &fa = res->all_attributes.emplace_back();
+                    fa.first = res->all_values.data()+res->all_values.size();
+                    if (av.is_list()) {
+                        auto &list = std::get<std::vector<textx::object::Value>>(av.data);
+                        fa.list = true;
+                        fa.count = static_cast<std::uint32_t>(list.size());
+                        for (auto &v: list) freeze_value(v);
+                    }
+                    else {
+                        fa.count = 1;
+                        freeze_value(std::get<textx::object::Value>(av.data));
+                    }
+                }
+            }
+        }
+        TEXTX_ASSERT(res->all_attributes.size()==n_attributes && res->all_values.size()==n_values); // no reallocation
+        res->m_root = &res->all_objects[0];
+        return res;
+    }
+
+    textx::object::TypeId FrozenModel::type_id(std::string_view type) const {
+        return mm->type_id(std::string{type});
+    }
+
+    bool FrozenModel::is_instance(const FrozenObject& obj, textx::object::TypeId type) const {
+        return mm->is_instance(obj.type_id(), type);
+    }
+
+    std::vector<const FrozenObject*> FrozenModel::all_of(std::string_view type, bool include_imports) const {
+        auto id = type_id(type);
+        std::vector<const FrozenObject*> res;
+        for (auto &obj: include_imports ? objects() : own_objects()) {
+            if (is_instance(obj, id)) res.push_back(&obj);
+        }
+        return res;
+    }
+}
+
+namespace textx {
+
+    std::shared_ptr<const textx::frozen::FrozenModel> Model::freeze() {
+        return textx::frozen::FrozenModel::create(shared_from_this());
+    }
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include "textx/object.h"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <span>
+
+namespace textx {
+    class Metamodel;
+    class Model;
+}
+
+/**
+ * Immutable snapshot of a model (see Model::freeze).
+ *
+ * All objects of the model and of its imported models are copied into
+ * contiguous arrays; references are direct pointers and string values are
+ * views into the model texts. There is only a const API and no lazily
+ * computed state, so any number of threads can read a FrozenModel without
+ * synchronization (no reference counting or weak_ptr::lock on access).
+ */
+namespace textx::frozen {
+
+    class FrozenObject;
+    class FrozenAttribute;
+    class FrozenModel;
+
+    class FrozenValue {
+        enum class Kind : std::uint8_t { null, str, obj, ref, boolean };
+        Kind kind = Kind::null;
+        textx::object::Scalar scalar = textx::object::Scalar::none; /// see MatchText (Kind::boolean: boolean_value)
+        bool number = false;
+        std::string_view text = {};     /// see Value::str_view
+        const FrozenObject* object = nullptr;
+        union {
+            std::int64_t int_value = 0;
+            double float_value;
+            bool boolean_value;
+        };
+        textx::arpeggio::TextPosition m_pos = {};
+        friend FrozenModel;
+    public:
+        bool is_null() const { return (kind==Kind::obj || kind==Kind::ref) && object==nullptr; }
+        bool is_str() const { return kind==Kind::str; }
+        bool is_number() const { return number; }
+        bool is_boolean() const { return kind==Kind::boolean; }
+        bool is_ref() const { return kind==Kind::ref; }
+        bool is_pure_obj() const { return kind==Kind::obj; }
+        bool is_obj() const { return kind==Kind::obj || kind==Kind::ref; }
+        textx::arpeggio::TextPosition pos() const { return m_pos; }
+
+        /** the contained or referenced object (nullptr for unresolved references) */
+        const FrozenObject* obj() const {
+            TEXTX_ASSERT(is_obj(), "no object at ", m_pos);
+            return object;
+        }
+        std::string_view str_view() const {
+            TEXTX_ASSERT(is_str(), "no text at ", m_pos);
+            return text;
+        }
+        std::string str() const { return std::string{str_view()}; }
+        /** see Value::boolean */
+        bool boolean() const {
+            TEXTX_ASSERT(is_boolean() || scalar==textx::object::Scalar::boolean, "no boolean at ", m_pos);
+            return boolean_value;
+        }
+        long double f() const {
+            if (scalar==textx::object::Scalar::floating) return float_value;
+            if (scalar==textx::object::Scalar::integer) return int_value;
+            return std::stold(str());
+        }
+        long long i() const {
+            if (scalar==textx::object::Scalar::integer) return int_value;
+            return std::stoll(str(), nullptr, 0);
+        }
+        unsigned long long u() const {
+            if (scalar==textx::object::Scalar::integer && int_value>=0) return static_cast<unsigned long long>(int_value);
+            return std::stoull(str(), nullptr, 0);
+        }
+        const FrozenAttribute& operator[](std::string_view name) const;
+    };
+
+    /** a scalar attribute (one value) or a list */
+    class FrozenAttribute {
+        const FrozenValue* first = nullptr;
+        std::uint32_t count = 0;
+        bool list = false;
+        friend FrozenModel;
+    public:
+        bool is_list() const { return list; }
+        size_t size() const {
+            TEXTX_ASSERT(list, "no list");
+            return count;
+        }
+        const FrozenValue* begin() const { return first; }
+        const FrozenValue* end() const { return first+count; }
+        const FrozenValue& operator[](size_t idx) const {
+            TEXTX_ASSERT(list && idx<count, "index out of bounds: index ", idx, " must be <", count);
+            return first[idx];
+        }
+        const FrozenValue& value() const {
+            TEXTX_ASSERT(!list, "attribute is a list");
+            return *first;
+        }
+
+        bool is_null() const { return !list && value().is_null(); }
+        bool is_str() const { return !list && value().is_str(); }
+        bool is_number() const { return !list && value().is_number(); }
+        bool is_boolean() const { return !list && value().is_boolean(); }
+        bool is_ref() const { return !list && value().is_ref(); }
+        bool is_obj() const { return !list && value().is_obj(); }
+        const FrozenObject* obj() const { return value().obj(); }
+        std::string_view str_view() const { return value().str_view(); }
+        std::string str() const { return value().str(); }
+        bool boolean() const { return value().boolean(); }
+        long double f() const { return value().f(); }
+        long long i() const { return value().i(); }
+        unsigned long long u() const { return value().u(); }
+        const FrozenAttribute& operator[](std::string_view name) const { return value()[name]; }
+    };
+
+    class FrozenObject {
+        std::string_view m_type = {};               /// interned rule name
+        textx::object::TypeId m_type_id = 0;        /// type space of FrozenModel::tx_metamodel
+        const FrozenObject* m_parent = nullptr;
+        const textx::object::AttributeLayout* layout = nullptr;
+        const FrozenAttribute* attributes = nullptr;
+        textx::arpeggio::TextPosition m_pos = {};
+        friend FrozenModel;
+    public:
+        std::string_view type() const { return m_type; }
+        textx::object::TypeId type_id() const { return m_type_id; }
+        const FrozenObject* parent() const { return m_parent; }
+        textx::arpeggio::TextPosition pos() const { return m_pos; }
+        const std::vector<std::string>& attribute_names() const { return layout->names; }
+        bool has_attr(std::string_view name) const { return layout->slot(name).has_value(); }
+        const FrozenAttribute& operator[](std::string_view name) const {
+            auto slot = layout->slot(name);
+            if (!slot.has_value()) {
+                throw std::runtime_error(std::string("attribute ")+std::string{name}+" not found.");
+            }
+            return attributes[slot.value()];
+        }
+        /** key from Rule::tx_attr_key (same layout as the source object) */
+        const FrozenAttribute& operator[](textx::object::AttrKey key) const {
+            if (key.layout==layout) return attributes[key.slot];
+            return (*this)[key.name()]; // other layout
+        }
+    };
+
+    inline const FrozenAttribute& FrozenValue::operator[](std::string_view name) const {
+        auto o = obj();
+        TEXTX_ASSERT(o!=nullptr, "null object at ", m_pos);
+        return (*o)[name];
+    }
+
+    class FrozenModel {
+        std::shared_ptr<const textx::Metamodel> mm;
+        std::vector<FrozenObject> all_objects = {};
+        std::vector<FrozenAttribute> all_attributes = {};
+        std::vector<FrozenValue> all_values = {};
+        std::vector<std::shared_ptr<const textx::object::AttributeLayout>> layouts = {};
+        std::vector<std::shared_ptr<const std::string>> texts = {}; /// model texts viewed by the string values (see MatchText)
+        std::vector<std::shared_ptr<const std::deque<std::string>>> strings = {}; /// unescaped strings of the models (see Model::model_strings)
+        std::deque<std::string> copied_texts = {}; /// text owned by values created outside a model (may change with the model)
+        const FrozenObject* m_root = nullptr;
+        size_t m_own_object_count = 0;
+        FrozenModel() = default;
+    public:
+        FrozenModel(const FrozenModel&) = delete;
+        FrozenModel& operator=(const FrozenModel&) = delete;
+
+        /** snapshot of m and all (transitively) imported models */
+        static std::shared_ptr<const FrozenModel> create(const std::shared_ptr<textx::Model>& m);
+
+        const FrozenObject& root() const { return *m_root; }
+        const FrozenAttribute& operator[](std::string_view name) const { return root()[name]; }
+        const std::shared_ptr<const textx::Metamodel>& tx_metamodel() const { return mm; }
+        /** all objects in traversal order (the objects of the frozen model first, then the imported ones) */
+        std::span<const FrozenObject> objects() const { return all_objects; }
+        /** the objects of the frozen model (w/o the imported ones) */
+        std::span<const FrozenObject> own_objects() const { return std::span<const FrozenObject>{all_objects}.first(m_own_object_count); }
+
+        textx::object::TypeId type_id(std::string_view type) const;
+        bool is_instance(const FrozenObject& obj, textx::object::TypeId type) const;
+        /** all objects of a type (incl. derived types) in traversal order */
+        std::vector<const FrozenObject*> all_of(std::string_view type, bool include_imports=false) const;
+    };
+}
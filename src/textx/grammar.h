@@ -15,12 +15,18 @@ namespace textx
         bool ok = true;
         std::unordered_map<std::string, R> rules = {};
         bool default_skipws = true;
+        bool collect_memo_usage = false;
+        textx::MemoryUsage last_memo_usage = {};
 
     public:
         Grammar() = default;
         Grammar(R r) { add_rule("main", r); }
 
         void set_default_skipws(bool s) { default_skipws=s; }
+        /** measure the memo table of each parse before it is released (see tx_memo_usage) */
+        void set_collect_memo_usage(bool c) { collect_memo_usage=c; }
+        /** memo table of the last parse (if enabled by set_collect_memo_usage) */
+        const textx::MemoryUsage& tx_memo_usage() const { return last_memo_usage; }
 
         auto ref(std::string name)
         {
@@ -95,9 +101,15 @@ namespace textx
             }
         }
 
-        std::optional<textx::arpeggio::Match> parse(std::string_view text)
+        /**
+         * parses text with a caller owned state (reentrant: several threads may
+         * parse with the same grammar). memo_usage receives the size of the
+         * memo table (if not nullptr); the table is released afterwards.
+         */
+        std::optional<textx::arpeggio::Match> parse(std::string_view text, textx::arpeggio::ParserState &parser_state, textx::MemoryUsage* memo_usage=nullptr) const
         {
-            if (rules.count(main_rule_name)!=1)
+            auto main_rule = rules.find(main_rule_name);
+            if (main_rule==rules.end())
             {
                 for (auto [k,v]: rules) {
                     std::cout << k << "\n";
@@ -105,7 +117,7 @@ namespace textx
                 throw std::runtime_error(std::string("unexpected: no main rule found in grammar; name=")+main_rule_name);
             }
             auto main = textx::arpeggio::sequence({
-                rules[main_rule_name],
+                main_rule->second,
                 textx::arpeggio::end_of_file()
             });
             if (default_skipws==false) {
@@ -114,10 +126,13 @@ namespace textx
             else {
                 main = textx::arpeggio::skipws(main);
             }
-            state = textx::arpeggio::ParserState{text};
-            auto res = main(config, state, {});
-            ok = res.has_value();
-            if (ok) {
+            parser_state = textx::arpeggio::ParserState{text};
+            auto res = main(config, parser_state, {});
+            if (memo_usage!=nullptr) {
+                *memo_usage = textx::arpeggio::memory_usage(parser_state.memo);
+            }
+            parser_state.memo = {}; // the matches are copied into the result
+            if (res.has_value()) {
                 return res.value().children[0];
             }
             else {
@@ -125,6 +140,24 @@ namespace textx
             }
         }
 
+        /** like parse(text, parser_state), but raises on errors */
+        std::optional<textx::arpeggio::Match> parse_or_throw(std::string_view text, textx::arpeggio::ParserState &parser_state, textx::MemoryUsage* memo_usage=nullptr) const
+        {
+            auto res = parse(text, parser_state, memo_usage);
+            if (!res) {
+                textx::arpeggio::raise( parser_state.farthest_position.text_position, error_string(parser_state.farthest_position) );
+            }
+            return res;
+        }
+
+        std::optional<textx::arpeggio::Match> parse(std::string_view text)
+        {
+            last_memo_usage = {};
+            auto res = parse(text, state, collect_memo_usage ? &last_memo_usage : nullptr);
+            ok = res.has_value();
+            return res;
+        }
+
         std::optional<textx::arpeggio::Match> parse_or_throw(std::string_view text)
         {
             auto res = parse(text);
@@ -147,18 +180,23 @@ namespace textx
         {
             main_rule_name = std::string(name);
         }
-        std::string get_main_rule_name()
+        std::string get_main_rule_name() const
         {
             return main_rule_name;
         }
 
         std::string get_last_error_string(std::optional<std::string_view> text = std::nullopt)
         {
-            std::ostringstream s;
             auto pos = get_last_error_position();
             // if (text) {
             //     textx::arpeggio::print_error_position(s, text.value(), pos.text_position);
             // }
+            return error_string(pos);
+        }
+
+        static std::string error_string(const textx::arpeggio::AnnotatedTextPosition& pos)
+        {
+            std::ostringstream s;
             s << pos.text_position.line << ":" << pos.text_position.col << ":"
               << "expected\n" << pos;
             return s.str();
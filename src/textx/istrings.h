@@ -200,7 +200,16 @@ namespace textx::istrings {
         struct Formatter {
             FormatterStream &s;
             std::unordered_map<std::string,textx::istrings::ExternalLink> &external_links;
-            std::unordered_map<std::string,std::shared_ptr<textx::object::Object>> loop_obj;
+            std::unordered_map<std::string,std::shared_ptr<textx::object::Object>> loop_obj = {};
+            std::unordered_map<const textx::object::Object*,textx::object::PathQuery> queries = {}; // compiled "fqn" of the commands
+
+            const textx::object::PathQuery& get_query(const textx::object::Object& cmd, const textx::object::AttributeValue& fqn) {
+                auto p = queries.find(&cmd);
+                if (p==queries.end()) {
+                    p = queries.emplace(&cmd, textx::object::PathQuery{fqn.str_view()}).first;
+                }
+                return p->second;
+            }
 
             std::shared_ptr<textx::object::Object> get_obj(std::shared_ptr<textx::object::Object> ref_obj) {
                 if (ref_obj->type == "Object") {
@@ -222,14 +231,14 @@ namespace textx::istrings {
 
             void format_CommandObjAttributeAsString(std::shared_ptr<textx::object::Object> cmd) {
                 auto obj = get_obj((*cmd)["obj"].obj());
-                s << obj->fqn_attributes( (*cmd)["fqn"].str() ).str();
+                s << get_query(*cmd, (*cmd)["fqn"])(*obj).str_view();
             }
             void format_CommandForLoop(std::shared_ptr<textx::object::Object> cmd) {
                 auto name = (*cmd)["name"].str();
                 auto obj = get_obj( (*cmd)["obj"].obj() );
-                auto fqn_query = (*cmd)["fqn"].str();
+                auto &fqn_query = get_query(*cmd, (*cmd)["fqn"]);
                 s.inc_level();
-                for(auto &e: obj->fqn_attributes(fqn_query)) {
+                for(auto &e: fqn_query(*obj)) {
                     s.nontextual_cmd(); // for
                     loop_obj[name] = e.obj();
                     format_obj( (*cmd)["body"]["body"].obj() );
@@ -242,7 +251,7 @@ namespace textx::istrings {
                 auto fun = std::get<textx::istrings::Obj2StrFun>(external_links[(*cmd)["call"]["name"].str()]);
                 auto obj = get_obj( (*cmd)["obj"].obj() );
                 if (!(*cmd)["fqn"].is_null()) {
-                    obj = obj->fqn_attributes( (*cmd)["fqn"]["value"].str() ).obj();
+                    obj = get_query(*cmd, (*cmd)["fqn"]["value"])(*obj).obj();
                 }
                 std::string res = fun(obj);
                 res = add_intend_after_newline(res, s.current_col());
@@ -258,7 +267,7 @@ namespace textx::istrings {
             }
             void format_text(std::shared_ptr<textx::object::Object> obj) {
                 for(auto &t: (*obj)["text"]) {
-                    s << t["text"].str();
+                    s << t["text"].str_view();
                 }
             }
             void format_part(std::shared_ptr<textx::object::Object> part) {
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Memory accounting of models (see Model::tx_memory_stats).
+ *
+ * The numbers are computed from the sizes and capacities of the data
+ * structures (no allocator hooks): they are deterministic, and thus usable
+ * to detect regressions in benchmarks, but ignore allocator overhead.
+ */
+namespace textx {
+
+    /** heap bytes and number of heap allocations */
+    struct MemoryUsage {
+        size_t bytes = 0;
+        size_t allocations = 0;
+
+        void add(size_t n_bytes, size_t n_allocations=1) {
+            bytes += n_bytes;
+            allocations += n_allocations;
+        }
+        /** the heap buffer of s (if not stored inline, small string optimization) */
+        void add(const std::string& s) {
+            auto data = reinterpret_cast<const char*>(s.data());
+            auto self = reinterpret_cast<const char*>(&s);
+            if (data<self || data>=self+sizeof(s)) add(s.capacity()+1);
+        }
+        /** the buffer of v (not the heap memory of the elements) */
+        template<class T>
+        void add(const std::vector<T>& v) {
+            if (v.capacity()>0) add(v.capacity()*sizeof(T));
+        }
+        MemoryUsage& operator+=(const MemoryUsage& other) {
+            add(other.bytes, other.allocations);
+            return *this;
+        }
+    };
+
+    /** memory per phase of Metamodel::model_from_str */
+    struct MemoryStats {
+        MemoryUsage memo_tables = {};   /// parser memoization (freed after parsing, see ModelOptions::collect_parse_memory_stats)
+        MemoryUsage parse_tree = {};    /// arpeggio::Match tree (freed after the model is created, see above)
+        MemoryUsage objects = {};       /// objects, attributes and values
+        MemoryUsage strings = {};       /// model text, copied texts and type names
+        MemoryUsage references = {};    /// names and matched paths of references
+
+        /** the retained memory (objects, strings and references) */
+        MemoryUsage retained() const {
+            MemoryUsage res = objects;
+            res += strings;
+            res += references;
+            return res;
+        }
+        /** all phases (the parser memory is a temporary peak) */
+        MemoryUsage total() const {
+            MemoryUsage res = retained();
+            res += memo_tables;
+            res += parse_tree;
+            return res;
+        }
+        MemoryStats& operator+=(const MemoryStats& other) {
+            memo_tables += other.memo_tables;
+            parse_tree += other.parse_tree;
+            objects += other.objects;
+            strings += other.strings;
+            references += other.references;
+            return *this;
+        }
+
+        /** one line "<prefix><phase> bytes=<n> allocations=<n>" per phase and for the total */
+        void print(std::ostream& o, std::string_view prefix="") const {
+            auto line = [&](std::string_view name, const MemoryUsage& u) {
+                o << prefix << name << " bytes=" << u.bytes << " allocations=" << u.allocations << "\n";
+            };
+            line("memo_tables", memo_tables);
+            line("parse_tree", parse_tree);
+            line("objects", objects);
+            line("strings", strings);
+            line("references", references);
+            line("total", total());
+        }
+    };
+}
@@ -4,6 +4,12 @@
 #include "textx/arpeggio.h"
 #include <cassert>
 #include <unordered_set>
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <mutex>
+#include <exception>
+#include <optional>
 
 namespace textx {
 
@@ -97,6 +103,11 @@ namespace textx {
                 new_rule.post_process_created_rule(*this, rule_name, rule_params, rule_body);
             }
 
+            // optimize and create the parsers (all rule expressions are known now)
+            for (auto&r : rules.children) {
+                grammar[r.children[0].captured.value()].compile(*this);
+            }
+
             // fill "all types"
             get_all_types(all_types);
 
@@ -116,6 +127,9 @@ namespace textx {
                 unresolved_rules = unresolved_rules_new;
             }
 
+            // type ids (all rule types and the inheritance are known now)
+            finalize_types();
+
             for (auto&[name,r] : grammar) {
                 r.adjust_attr_types(*this);
             }
@@ -145,7 +159,7 @@ namespace textx {
         }
     }
 
-    std::string Metamodel::get_fqn_for_rule(std::string name) const {
+    std::string Metamodel::search_fqn_for_rule(std::string name) const {
         if (name=="OBJECT") {
             return name;
         }
@@ -201,7 +215,7 @@ namespace textx {
         throw std::runtime_error(std::string("rule ")+name+" not found.");
     }
 
-    bool Metamodel::has_rule(std::string name, bool allow_referenced_mm) const {
+    bool Metamodel::search_has_rule(std::string name, bool allow_referenced_mm) const {
         size_t n = name.find(".");
         if (n!=name.npos && name.substr(0,n)==grammar_name) {
             name = name.substr(n+1);
@@ -209,12 +223,10 @@ namespace textx {
         }
         if (n!=name.npos) {
             auto res = imported_models_by_name.find(name.substr(0,n));
-            if (res==imported_models_by_name.end() && allow_referenced_mm) {
+            if (res==imported_models_by_name.end()) {
+                if (!allow_referenced_mm) return false; // unknown grammar
                 res = referenced_models_by_name.find(name.substr(0,n));
-                TEXTX_ASSERT(res!=referenced_models_by_name.end(), "grammar ", name.substr(0,n), " not found.");
-            }
-            else {
-                TEXTX_ASSERT(res!=imported_models_by_name.end(), "grammar ", name.substr(0,n), " not found.");
+                if (res==referenced_models_by_name.end()) return false; // unknown grammar
             }
             auto sp = res->second.lock();
             TEXTX_ASSERT(sp!=nullptr);
@@ -279,10 +291,85 @@ namespace textx {
         };
     }
 
-    Rule& Metamodel::operator[](std::string name) {
+    std::string Metamodel::get_fqn_for_rule(std::string_view name) const {
+        auto symbol = find_symbol(name);
+        if (symbol!=nullptr && !symbol->fqn.empty()) {
+            return symbol->fqn;
+        }
+        return search_fqn_for_rule(std::string{name});
+    }
+
+    bool Metamodel::has_rule(std::string_view name, bool allow_referenced_mm) const {
+        if (types_finalized) {
+            auto symbol = find_symbol(name);
+            if (symbol!=nullptr) {
+                return (allow_referenced_mm ? symbol->rule : symbol->local_rule) != nullptr;
+            }
+            if (name.find('.')==name.npos) {
+                return false; // all plain names are known
+            }
+        }
+        return search_has_rule(std::string{name}, allow_referenced_mm);
+    }
+
+    Rule& Metamodel::find_rule(std::string_view name, bool allow_referenced_mm) {
+        auto symbol = find_symbol(name);
+        if (symbol!=nullptr) {
+            auto rule = allow_referenced_mm ? symbol->rule : symbol->local_rule;
+            if (rule!=nullptr) return *rule;
+        }
+        return search_rule(std::string{name}, allow_referenced_mm);
+    }
+
+    const Rule& Metamodel::find_rule(std::string_view name, bool allow_referenced_mm) const {
+        auto symbol = find_symbol(name);
+        if (symbol!=nullptr) {
+            auto rule = allow_referenced_mm ? symbol->rule : symbol->local_rule;
+            if (rule!=nullptr) return *rule;
+        }
+        return search_rule(std::string{name}, allow_referenced_mm);
+    }
+
+    void Metamodel::fill_symbols() {
+        // the symbol table caches the results of the search functions for all
+        // rule names of all visible metamodels, with and without grammar prefix
+        // (other names, e.g. "A.B.Rule", are still searched).
+        std::vector<std::string> prefixes = {""};
+        if (!grammar_name.empty()) {
+            prefixes.push_back(grammar_name+".");
+        }
+        for (auto& [name, weak_other_mm]: imported_models_by_name) {
+            prefixes.push_back(name+".");
+        }
+        for (auto& [name, weak_other_mm]: referenced_models_by_name) {
+            prefixes.push_back(name+".");
+        }
+        symbols.clear();
+        for (size_t id=1;id<types_by_id.size();id++) {
+            for (auto& prefix: prefixes) {
+                std::string name = prefix+types_by_id[id]->tx_name();
+                if (symbols.count(name)>0) continue;
+                Symbol symbol;
+                try {
+                    if (search_has_rule(name, true)) symbol.rule = &search_rule(name, true);
+                } catch(std::exception&) {}
+                try {
+                    if (search_has_rule(name, false)) symbol.local_rule = &search_rule(name, false);
+                } catch(std::exception&) {}
+                try {
+                    symbol.fqn = search_fqn_for_rule(name);
+                } catch(std::exception&) {}
+                if (symbol.rule!=nullptr || symbol.local_rule!=nullptr) {
+                    symbols.emplace(std::move(name), std::move(symbol));
+                }
+            }
+        }
+    }
+
+    Rule& Metamodel::operator[](std::string_view name) {
         return find_rule(name, true);
     }
-    Rule& Metamodel::find_rule(std::string name, bool allow_referenced_mm) {
+    Rule& Metamodel::search_rule(std::string name, bool allow_referenced_mm) {
         size_t n = name.find(".");
         if (n!=name.npos && name.substr(0,n)==grammar_name) {
             name = name.substr(n+1);
@@ -325,10 +412,10 @@ namespace textx {
         throw std::runtime_error(std::string("cannot find rule \"")+name+"\";");
     }
 
-    const Rule& Metamodel::operator[](std::string name) const {
+    const Rule& Metamodel::operator[](std::string_view name) const {
         return find_rule(name, true);
     }
-    const Rule& Metamodel::find_rule(std::string name, bool allow_referenced_mm) const {
+    const Rule& Metamodel::search_rule(std::string name, bool allow_referenced_mm) const {
         size_t n = name.find(".");
         if (n!=name.npos && name.substr(0,n)==grammar_name) {
             name = name.substr(n+1);
@@ -383,6 +470,220 @@ namespace textx {
         }
     }
 
+    struct Metamodel::ImportGraph {
+        struct Node {
+            std::shared_ptr<textx::Model> model;
+            std::vector<std::string> imports;   /// canonical filenames in import order
+            std::vector<std::shared_ptr<textx::Model>> builtin_models;
+        };
+        std::mutex mutex;
+        std::vector<Node> nodes = {};
+        std::unordered_map<std::string, std::string> canonical_paths = {}; /// cached filesystem lookups ("": not found)
+
+        std::string canonical(const std::filesystem::path& p) {
+            auto key = p.string();
+            {
+                std::lock_guard lock{mutex};
+                auto f = canonical_paths.find(key);
+                if (f!=canonical_paths.end()) return f->second;
+            }
+            std::string res = std::filesystem::exists(p) ? std::filesystem::canonical(p).string() : "";
+            std::lock_guard lock{mutex};
+            canonical_paths.emplace(key, res);
+            return res;
+        }
+    };
+
+    thread_local Metamodel::ImportGraph* Metamodel::current_import_graph = nullptr;
+
+    std::vector<std::string> Metamodel::import_filenames(textx::Model& m, const std::string& filename, ImportGraph& graph) const {
+        auto basedir = std::filesystem::path(filename).parent_path();
+        auto basedir0 = std::filesystem::path(".");
+        std::vector<std::string> res;
+        for (auto &obj: textx::object::objects(m.val())) {
+            if (obj.has_attr("importURI")) {
+                TEXTX_ASSERT(obj["importURI"].is_str(), "importURI must be a string");
+                auto import_filename = obj["importURI"].str();
+                auto fn = graph.canonical(basedir/import_filename);
+                if (fn.empty()) {
+                    fn = graph.canonical(basedir0/import_filename);
+                }
+                if (fn.empty()) {
+                    textx::arpeggio::raise(obj.pos, import_filename+" not found.");
+                }
+                res.push_back(fn);
+            }
+        }
+        return res;
+    }
+
+    void Metamodel::load_import_graph(ImportGraph& graph, const std::shared_ptr<textx::Workspace>& workspace) const {
+        // level by level: the new imports of the models loaded so far are parsed concurrently
+        // (the models register themselves in the graph, see model_from_str)
+        std::unordered_set<std::string> scheduled;
+        size_t done = 0;
+        std::optional<textx::utils::ThreadPool> pool; // started with the first level of more than one model
+        auto refresh = textx::Workspace::current_refresh; // see Workspace::refresh
+        while (true) {
+            std::vector<std::string> level;
+            for (; done<graph.nodes.size(); done++) {
+                for (auto &fn: graph.nodes[done].imports) {
+                    if (scheduled.insert(fn).second && !workspace->has_model(fn)) {
+                        level.push_back(fn);
+                    }
+                }
+            }
+            if (level.empty()) break;
+            std::vector<std::exception_ptr> errors(level.size());
+            if (!pool && level.size()>1 && model_options.import_threads!=1) pool.emplace(model_options.import_threads);
+            auto load = [&](size_t i) {
+                auto outer = current_import_graph;
+                auto outer_refresh = textx::Workspace::current_refresh;
+                current_import_graph = &graph;
+                textx::Workspace::current_refresh = refresh;
+                try {
+                    (void)workspace->model_from_file(level[i], false);
+                }
+                catch (...) {
+                    errors[i] = std::current_exception();
+                }
+                current_import_graph = outer;
+                textx::Workspace::current_refresh = outer_refresh;
+            };
+            if (pool) pool->parallel_for(level.size(), load, 1);
+            else for (size_t i=0;i<level.size();i++) load(i);
+            for (auto &e: errors) {
+                if (e) std::rethrow_exception(e);
+            }
+        }
+        // link all models (imports in order, then the builtin models)
+        for (auto &node: graph.nodes) {
+            for (auto &fn: node.imports) {
+                auto m = workspace->get_model(fn);
+                TEXTX_ASSERT(m!=nullptr, "unexpected: ", fn, " not loaded");
+                node.model->add_imported_model(m);
+            }
+            for (auto &builtin_model: node.builtin_models) {
+                node.model->add_imported_model(builtin_model);
+            }
+        }
+    }
+
+    void Metamodel::resolve_references(const std::unordered_set<std::shared_ptr<textx::Model>>& models, size_t threads, textx::object::StagedResolution* staged) {
+        // the staged target of a reference (nullptr: the reference itself is resolved)
+        auto staged_target = [&](const textx::object::ObjectRef& ref) -> textx::object::StagedResolution::Target* {
+            if (staged==nullptr) return nullptr;
+            auto p = staged->refs.find(&ref);
+            return (p==staged->refs.end()) ? nullptr : &p->second;
+        };
+        auto is_resolved = [&](const textx::object::ObjectRef& ref) {
+            auto target = staged_target(ref);
+            return ((target!=nullptr) ? target->obj.lock() : ref.obj.lock())!=nullptr;
+        };
+        // worklist: all unresolved references (in traversal order)
+        struct Item {
+            textx::Model* model;
+            textx::object::Value* value;
+        };
+        std::vector<Item> items;
+        for (auto &m: models) {
+            for (auto &v: textx::object::tree(m->val())) {
+                if (v.is_ref() && !is_resolved(v.ref())) {
+                    items.push_back({m.get(), &v});
+                }
+            }
+        }
+        // results of a round (the models are only read while resolving)
+        struct Result {
+            std::shared_ptr<textx::object::Object> obj = nullptr;
+            textx::object::MatchedPath objpath = {};
+            const textx::object::ObjectRef* blocker = nullptr; /// first unresolved blocking reference
+            std::exception_ptr error = nullptr;
+        };
+        auto resolve = [&](size_t idx, Result& res) {
+            auto outer = std::exchange(textx::object::StagedResolution::current, staged);
+            try {
+                textx::scoping::BlockingReferences blocking;
+                std::tie(res.obj, res.objpath) = items[idx].model->find_reference_target(items[idx].value->ref());
+                auto blocker = std::find_if(blocking.get().begin(), blocking.get().end(), [&](auto ref) { return !is_resolved(*ref); });
+                if (blocker!=blocking.get().end()) res.blocker = *blocker;
+            }
+            catch (...) {
+                res.error = std::current_exception();
+            }
+            textx::object::StagedResolution::current = outer;
+        };
+
+        std::vector<size_t> round(items.size());
+        std::iota(round.begin(), round.end(), 0);
+        std::unordered_map<const textx::object::ObjectRef*, std::vector<size_t>> waiting; // postponed items per blocking reference
+        std::vector<size_t> not_found;
+        constexpr size_t block = 16; // references per task
+        std::optional<textx::utils::ThreadPool> pool; // started once for all rounds (if a round is large enough)
+        while (true) {
+            size_t resolved = 0;
+            while (!round.empty()) {
+                std::vector<Result> results(round.size());
+                auto resolve_round = [&](size_t k) { resolve(round[k], results[k]); };
+                if (!pool && threads!=1 && round.size()>block) pool.emplace(threads);
+                if (pool) pool->parallel_for(round.size(), resolve_round, block);
+                else for (size_t k=0;k<round.size();k++) resolve_round(k);
+                // commit in worklist order (independent of the number of threads)
+                std::vector<size_t> next;
+                for (size_t k=0;k<round.size();k++) {
+                    auto idx = round[k];
+                    auto &res = results[k];
+                    if (res.error) std::rethrow_exception(res.error);
+                    auto &ref = items[idx].value->ref();
+                    if (res.obj!=nullptr) {
+                        if (auto target = staged_target(ref)) {
+                            *target = {res.obj, std::move(res.objpath)};
+                        }
+                        else {
+                            ref.obj = res.obj;
+                            ref.objpath = std::move(res.objpath);
+                        }
+                        resolved++;
+                        auto w = waiting.find(&ref);
+                        if (w!=waiting.end()) {
+                            next.insert(next.end(), w->second.begin(), w->second.end());
+                            waiting.erase(w);
+                        }
+                    }
+                    else if (res.blocker!=nullptr && is_resolved(*res.blocker)) {
+                        next.push_back(idx); // resolved in this round
+                    }
+                    else if (res.blocker!=nullptr) {
+                        waiting[res.blocker].push_back(idx);
+                    }
+                    else {
+                        not_found.push_back(idx);
+                    }
+                }
+                round = std::move(next);
+            }
+            // resolvers which do not report blocking references: retry while references get resolved
+            if (not_found.empty() || resolved==0) break;
+            round = std::move(not_found);
+            not_found.clear();
+        }
+
+        // errors: all left over references
+        for (auto &[ref, postponed]: waiting) {
+            not_found.insert(not_found.end(), postponed.begin(), postponed.end());
+        }
+        if (not_found.size()>0) {
+            std::sort(not_found.begin(), not_found.end());
+            std::stringstream error_text;
+            for (auto idx: not_found) {
+                auto &v = *items[idx].value;
+                error_text << "ref '" << v.ref().name << "' not found at " << v.pos << ";\n";
+            }
+            auto &last = items[not_found.back()];
+            textx::arpeggio::raise(last.model->tx_text(), last.model->tx_filename(), last.value->pos, error_text.str());
+        }
+    }
+
     std::shared_ptr<textx::Workspace> Metamodel::tx_default_workspace() {
         default_workspace->set_default_metamodel(shared_from_this()); 
         return default_workspace;
@@ -390,6 +691,9 @@ namespace textx {
 
     bool Metamodel::is_instance(std::string special, std::string base) const {
         //std::cout << "isinstance " << special << "--" << base << "\n";
+        if (types_finalized) {
+            return is_instance(type_id(special), type_id(base));
+        }
         auto fqn_special = get_fqn_for_rule(special);
         auto fqn_base = get_fqn_for_rule(base);
         if (fqn_special == fqn_base) {
@@ -401,6 +705,134 @@ namespace textx {
         return (operator[](base).tx_inh_by().count(special)>0);
     }
 
+    std::atomic<size_t> Metamodel::resolver_epoch = 1;
+
+    const textx::scoping::RefResolver& Metamodel::get_resolver(textx::object::TypeId rule_id, size_t attr_id) const {
+        size_t epoch = resolver_epoch.load();
+        if (resolver_table_epoch.load() != epoch) {
+            std::lock_guard<std::mutex> lock(resolver_table_mutex);
+            if (resolver_table_epoch.load() != epoch) {
+                TEXTX_ASSERT(types_finalized);
+                resolver_table.assign(types_by_id.size(), {});
+                for (size_t id=1;id<types_by_id.size();id++) {
+                    auto &rule = *types_by_id[id];
+                    for (auto &attr_name: rule.tx_attribute_names()) {
+                        resolver_table[id].push_back(&get_resolver(rule.tx_name(), attr_name));
+                    }
+                }
+                resolver_table_epoch.store(epoch);
+            }
+        }
+        TEXTX_ASSERT(rule_id<resolver_table.size() && attr_id<resolver_table[rule_id].size(), "unexpected rule/attribute id");
+        return *resolver_table[rule_id][attr_id];
+    }
+
+    std::uint32_t Metamodel::next_type_space() {
+        static std::atomic<std::uint32_t> next{1}; // 0 is reserved for objects w/o type id
+        return next++;
+    }
+
+    void Metamodel::finalize_types() {
+        // collect this and all imported/referenced metamodels (recursively, deterministic order)
+        std::vector<const Metamodel*> mms;
+        std::unordered_set<const Metamodel*> visited;
+        std::function<void(const Metamodel&)> collect;
+        collect = [&](const Metamodel& mm) {
+            if (!visited.insert(&mm).second) return;
+            mms.push_back(&mm);
+            for (auto& weak_other_mm: mm.imported_models) {
+                auto other_mm = weak_other_mm.lock();
+                TEXTX_ASSERT(other_mm != nullptr);
+                collect(*other_mm);
+            }
+            for (auto& weak_other_mm: mm.referenced_models) {
+                auto other_mm = weak_other_mm.lock();
+                TEXTX_ASSERT(other_mm != nullptr);
+                collect(*other_mm);
+            }
+        };
+        collect(*this);
+
+        // dense ids (0=OBJECT)
+        types_by_id = {nullptr};
+        type_ids_by_rule.clear();
+        std::vector<const Metamodel*> owner_by_id = {nullptr};
+        for (auto mm: mms) {
+            std::vector<std::string> names;
+            for (auto& [name, rule]: mm->grammar.get_rules()) {
+                names.push_back(name);
+            }
+            std::sort(names.begin(), names.end());
+            for (auto& name: names) {
+                const Rule* rule = &mm->grammar.get_rules().at(name);
+                type_ids_by_rule[rule] = static_cast<textx::object::TypeId>(types_by_id.size());
+                types_by_id.push_back(rule);
+                owner_by_id.push_back(mm);
+            }
+        }
+
+        // subtypes: the rule itself + tx_inh_by (names are resolved by the metamodel owning the rule)
+        size_t n = types_by_id.size();
+        subtypes_by_id.assign(n, boost::dynamic_bitset<>(n));
+        subtypes_by_id[0].set(); // everything is an OBJECT
+        for (size_t id=1;id<n;id++) {
+            subtypes_by_id[id].set(id);
+            for (auto& special: types_by_id[id]->tx_inh_by()) {
+                auto f = type_ids_by_rule.find(&(*owner_by_id[id])[special]);
+                TEXTX_ASSERT(f!=type_ids_by_rule.end(), "unexpected: no type id for ", special);
+                subtypes_by_id[id].set(f->second);
+            }
+        }
+        // transitive closure
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (size_t id=1;id<n;id++) {
+                auto closure = subtypes_by_id[id];
+                for (size_t s=closure.find_first(); s!=closure.npos; s=closure.find_next(s)) {
+                    closure |= subtypes_by_id[s];
+                }
+                if (closure!=subtypes_by_id[id]) {
+                    subtypes_by_id[id] = std::move(closure);
+                    changed = true;
+                }
+            }
+        }
+        fill_symbols();
+        types_finalized = true;
+    }
+
+    textx::object::TypeId Metamodel::type_id(std::string name) const {
+        if (name=="OBJECT") {
+            return 0;
+        }
+        return type_id(operator[](name));
+    }
+
+    textx::object::TypeId Metamodel::type_id(const Rule& rule) const {
+        TEXTX_ASSERT(types_finalized, "type ids are not available during metamodel construction");
+        auto f = type_ids_by_rule.find(&rule);
+        TEXTX_ASSERT(f!=type_ids_by_rule.end(), "rule ", rule.tx_name(), " has no type id in this metamodel");
+        return f->second;
+    }
+
+    textx::object::TypeId Metamodel::type_id(const textx::object::Object& obj) const {
+        if (obj.type_space==type_space) {
+            return obj.type_id;
+        }
+        if (obj.type_space!=0) { // object of another metamodel: translate via the rule
+            auto m = obj.tx_model();
+            auto other_mm = (m==nullptr)?nullptr:m->tx_metamodel();
+            if (other_mm!=nullptr && other_mm->type_space==obj.type_space) {
+                auto f = type_ids_by_rule.find(other_mm->types_by_id.at(obj.type_id));
+                if (f!=type_ids_by_rule.end()) {
+                    return f->second;
+                }
+            }
+        }
+        return type_id(obj.type);
+    }
+
     std::shared_ptr<textx::Model> Metamodel::model_from_str(std::string_view text, std::string filename, bool is_main_model, std::shared_ptr<textx::Workspace> workspace) {
         try {
             if (workspace==nullptr) {
@@ -410,65 +842,54 @@ namespace textx {
                 return workspace->get_model(filename); // cached model
             }
 
-            auto parsetree = parsetree_from_str(text);
+            textx::arpeggio::ParserState parser_state{text}; // own state: imports are parsed concurrently
+            textx::MemoryUsage memo_usage;
+            auto parsetree = grammar.parse_or_throw(text, parser_state, model_options.collect_parse_memory_stats ? &memo_usage : nullptr);
             auto ret=std::shared_ptr<textx::Model>{new textx::Model()}; // call private constructor (new)
             //std::cout << parsetree.value() << "\n";
             ret->init(filename, text, *parsetree, shared_from_this());
+            ret->weak_workspace = workspace;
+            ret->lazy_resolution_mutex = workspace->tx_lazy_resolution_mutex();
+            if (model_options.cache_scope_results) {
+                ret->scope_cache = std::make_unique<textx::scoping::ScopeCache>();
+            }
+            if (model_options.collect_parse_memory_stats) {
+                ret->parse_stats.memo_tables = memo_usage;
+                ret->parse_stats.parse_tree = textx::arpeggio::memory_usage(*parsetree);
+            }
 
             if (filename.size()>0) {
                 workspace->add_known_model(filename, ret); // owning...
             }
 
-            auto basedir = std::filesystem::path(filename).parent_path();
-            auto basedir0 = std::filesystem::path(".");
-            textx::object::traverse(ret->val(), [&, this](textx::object::Value& v) {
-                if (v.is_pure_obj() && !v.is_null() && v.obj()->has_attr("importURI")) {
-                    TEXTX_ASSERT(v["importURI"].is_str(), "importURI must be a string");
-                    auto import_filename = v["importURI"].str();
-                    auto p = basedir/import_filename;
-                    if (!std::filesystem::exists(p)) {
-                        p = basedir0/import_filename;
-                    }
-                    if (!std::filesystem::exists(p)) {
-                        textx::arpeggio::raise(v.obj()->pos, import_filename+" not found.");
-                    }
-                    auto m = workspace->model_from_file(p, false); // unresolved refs
-                    ret->add_imported_model(m);
-                }
-            });
- 
-            for (auto& builtin_model: builtin_models) {
-                ret->add_imported_model(builtin_model);
+            // imports: loaded and linked by the outermost model_from_str of the import graph
+            ImportGraph own_graph;
+            auto graph = current_import_graph!=nullptr ? current_import_graph : &own_graph;
+            ImportGraph::Node node{ret, import_filenames(*ret, filename, *graph), builtin_models};
+            if (graph==&own_graph) {
+                own_graph.nodes.push_back(std::move(node));
+                load_import_graph(own_graph, workspace);
+            }
+            else {
+                std::lock_guard lock{graph->mutex};
+                graph->nodes.push_back(std::move(node));
             }
 
             if (is_main_model) {
                 std::unordered_set<std::shared_ptr<Model>> all_models;
                 find_all_imported_models(ret, all_models);
 
-                size_t last_unresolved_refs=0;
-                size_t unresolved_refs=0;
-                do {
-                    last_unresolved_refs=unresolved_refs;
-                    unresolved_refs=0;
-                    for(auto m: all_models) {
-                        unresolved_refs += m->resolve_references();
-                    }
-                } while(unresolved_refs>0 && unresolved_refs!=last_unresolved_refs);
-
-                if (unresolved_refs>0) {
-                    textx::arpeggio::TextPosition pos;
-                    std::shared_ptr<textx::Model> err_model;
-                    std::stringstream error_text;
-                    for(auto m: all_models) {
-                        textx::object::traverse(m->val(),[&](textx::object::Value& v) {
-                            if (v.is_ref() && !v.ref().obj.lock()) {
-                                error_text << "ref '" << v.ref().name << "' not found at " << v.pos << ";\n";
-                                pos = v.pos;
-                                err_model = m;
+                if (model_options.lazy_references) {
+                    for (auto &m: all_models) {
+                        for (auto &v: textx::object::tree(m->val())) {
+                            if (v.is_ref() && v.ref().obj.lock()==nullptr) {
+                                v.ref().lazy.state = textx::object::LazyResolution::pending;
                             }
-                        });
+                        }
                     }
-                    textx::arpeggio::raise(err_model->tx_text(), err_model->tx_filename(), pos, error_text.str());
+                }
+                else {
+                    resolve_references(all_models, model_options.resolver_threads);
                 }
             }
             return ret;
@@ -4,11 +4,16 @@
 #include "textx/rule.h"
 #include "textx/model.h"
 #include "textx/scoping.h"
+#include "textx/utils.h"
 #include <string>
 #include <memory>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
+#include <cstdint>
+#include <mutex>
+#include <atomic>
+#include <boost/dynamic_bitset.hpp>
 
 namespace textx {
     class Workspace;
@@ -29,9 +34,49 @@ namespace textx {
         std::unordered_map<std::string, std::weak_ptr<textx::Metamodel>> referenced_models_by_name={};
         std::string grammar_name="";
         std::unordered_set<std::string> all_types={};
+        ModelOptions model_options={};
         void adjust_tx_inh_by();
+        // models of an import graph which are loaded, but not yet linked to their imports (see model_from_str)
+        struct ImportGraph;
+        static thread_local ImportGraph* current_import_graph; /// set while loading the imports of a graph
+        std::vector<std::string> import_filenames(textx::Model& m, const std::string& filename, ImportGraph& graph) const;
+        void load_import_graph(ImportGraph& graph, const std::shared_ptr<textx::Workspace>& workspace) const;
         void get_all_types(std::unordered_set<std::string> &res);
 
+        // type ids of all rules of this and all imported/referenced metamodels (see finalize_types)
+        static std::uint32_t next_type_space();
+        std::uint32_t type_space = next_type_space();
+        bool types_finalized = false;
+        std::vector<const Rule*> types_by_id = {};
+        std::unordered_map<const Rule*, textx::object::TypeId> type_ids_by_rule = {};
+        std::vector<boost::dynamic_bitset<>> subtypes_by_id = {}; /// subtypes_by_id[base][special]
+        void finalize_types();
+
+        // all plain and qualified rule names visible from this metamodel (see finalize_types)
+        struct Symbol {
+            Rule* rule = nullptr;       /// find_rule(name, true)
+            Rule* local_rule = nullptr; /// find_rule(name, false)
+            std::string fqn = "";
+        };
+        std::unordered_map<std::string, Symbol, textx::utils::string_hash, std::equal_to<>> symbols = {};
+        const Symbol* find_symbol(std::string_view name) const {
+            if (!types_finalized) return nullptr;
+            auto f = symbols.find(name);
+            return (f==symbols.end()) ? nullptr : &f->second;
+        }
+        void fill_symbols();
+        // lookup w/o symbol table (recursive search in imported/referenced metamodels)
+        Rule& search_rule(std::string name, bool allow_referenced_mm);
+        const Rule& search_rule(std::string name, bool allow_referenced_mm) const;
+        bool search_has_rule(std::string name, bool allow_referenced_mm) const;
+        std::string search_fqn_for_rule(std::string name) const;
+
+        // resolver for each (type id, attribute id); rebuilt after any set_resolver call (see get_resolver)
+        static std::atomic<size_t> resolver_epoch;
+        mutable std::mutex resolver_table_mutex;
+        mutable std::atomic<size_t> resolver_table_epoch = 0;
+        mutable std::vector<std::vector<const textx::scoping::RefResolver*>> resolver_table = {};
+
         public:
         Metamodel(std::string_view grammar, bool include_basic_metamodel=true, std::string filename="", std::shared_ptr<textx::Workspace> workspace=nullptr);
         std::shared_ptr<textx::Workspace> tx_default_workspace();
@@ -40,18 +85,41 @@ namespace textx {
             //std::cout << "IS_BASE_OF\n";
             return is_instance(special, base);
         }
-        Rule& operator[](std::string name);
-        const Rule& operator[](std::string name) const;
-        Rule& find_rule(std::string name, bool allow_referenced_mm);
-        const Rule& find_rule(std::string name, bool allow_referenced_mm) const;
-        bool has_rule(std::string name, bool allow_referenced_mm) const;
-        std::string get_fqn_for_rule(std::string name) const;
+
+        /** OBJECT has the type id 0; all rules visible from this metamodel have a dense id >0. */
+        textx::object::TypeId type_id(std::string name) const;
+        textx::object::TypeId type_id(const Rule& rule) const;
+        bool has_type_id(const Rule& rule) const { return type_ids_by_rule.count(&rule)>0; }
+        textx::object::TypeId type_id(const textx::object::Object& obj) const;
+        std::uint32_t tx_type_space() const { return type_space; }
+        size_t tx_type_count() const { return types_by_id.size(); }
+        /** the rule of a type id >0 */
+        const Rule& tx_rule(textx::object::TypeId id) const {
+            TEXTX_ASSERT(types_finalized && id>0 && id<types_by_id.size(), "unexpected type id");
+            return *types_by_id[id];
+        }
+        bool is_instance(textx::object::TypeId special, textx::object::TypeId base) const {
+            TEXTX_ASSERT(types_finalized && base<subtypes_by_id.size() && special<subtypes_by_id.size());
+            return subtypes_by_id[base][special];
+        }
+        bool is_instance(const textx::object::Object& obj, textx::object::TypeId base) const {
+            return is_instance(type_id(obj), base);
+        }
+        bool is_base_of(textx::object::TypeId base, textx::object::TypeId special) const {
+            return is_instance(special, base);
+        }
+        Rule& operator[](std::string_view name);
+        const Rule& operator[](std::string_view name) const;
+        Rule& find_rule(std::string_view name, bool allow_referenced_mm);
+        const Rule& find_rule(std::string_view name, bool allow_referenced_mm) const;
+        bool has_rule(std::string_view name, bool allow_referenced_mm) const;
+        std::string get_fqn_for_rule(std::string_view name) const;
         textx::arpeggio::Pattern ref(std::string name);
         std::string tx_grammar_name() {
             TEXTX_ASSERT(not grammar_name.empty());
             return grammar_name;
         }
-        std::string tx_main_rule_name() {
+        std::string tx_main_rule_name() const {
             return grammar.get_main_rule_name();
         }
 
@@ -63,8 +131,18 @@ namespace textx {
 
         std::shared_ptr<textx::Model> model_from_str(std::string_view text, std::string filename="", bool is_main_model=true, std::shared_ptr<textx::Workspace> workspace=nullptr);
         std::shared_ptr<textx::Model> model_from_file(std::filesystem::path p, bool is_main_model=true, std::shared_ptr<textx::Workspace> workspace=nullptr);
+        /**
+         * resolves all unresolved references of the models (and throws for
+         * unresolvable ones) with up to "threads" threads (see ModelOptions::resolver_threads).
+         * The references in staged->refs are resolved into staged, the models
+         * are not modified for them (see StagedResolution).
+         * Used by model_from_str, Model::validate_all_references and Workspace::refresh.
+         */
+        static void resolve_references(const std::unordered_set<std::shared_ptr<textx::Model>>& models, size_t threads, textx::object::StagedResolution* staged=nullptr);
 
         const auto& tx_all_types() const { return all_types; }
+        const ModelOptions& tx_model_options() const { return model_options; }
+        void set_model_options(ModelOptions options) { model_options = options; }
         void add_builtin_model(std::shared_ptr<textx::Model> m) { builtin_models.push_back(std::move(m)); }
         void clear_builtin_models() { builtin_models.clear(); }
 
@@ -109,8 +187,12 @@ namespace textx {
             return *default_resolver;
         }
 
+        /** same as get_resolver(rule_name, attr_name), but w/o string lookups (ids of the type space of this metamodel) */
+        const textx::scoping::RefResolver& get_resolver(textx::object::TypeId rule_id, size_t attr_id) const;
+
         void set_resolver(std::string dot_separated_rule_attr_with_asterix, std::unique_ptr<textx::scoping::RefResolver> r) {
             resolver.insert({dot_separated_rule_attr_with_asterix, std::move(r)});
+            resolver_epoch++; // invalidates the resolver tables of all metamodels (this one may be imported)
         }
 
         std::optional<textx::arpeggio::Match> parsetree_from_str(std::string_view model_txt) { return grammar.parse_or_throw(model_txt); }
@@ -2,15 +2,36 @@
 #include "textx/metamodel.h"
 #include "textx/arpeggio.h"
 #include "textx/rrel.h"
+#include "textx/workspace.h"
 
 namespace textx {
 
+    Model::~Model() {
+        root = {std::shared_ptr<textx::object::Object>{},{}};
+        for (auto p=arena_objects.rbegin(); p!=arena_objects.rend(); ++p) {
+            (*p)->~Object(); // memory is released with the arena
+        }
+    }
+
+    std::shared_ptr<textx::object::Object> Model::create_object(std::shared_ptr<textx::object::Object> parent, textx::arpeggio::TextPosition pos) {
+        if (arena==nullptr) {
+            return std::make_shared<textx::object::Object>(parent, pos);
+        }
+        void* mem = arena->allocate(sizeof(textx::object::Object), alignof(textx::object::Object));
+        auto obj = new (mem) textx::object::Object(parent, pos, arena.get()); // incl. the attribute slots
+        arena_objects.push_back(obj);
+        return std::shared_ptr<textx::object::Object>(std::shared_ptr<textx::object::Object>{}, obj); // non-owning
+    }
+
     void Model::init(const std::string_view filename, const std::string_view text, const textx::arpeggio::Match &parsetree, std::shared_ptr<Metamodel> mm) {
        weak_mm = mm;
-       model_text = text;
+       if (mm->tx_model_options().use_arena) {
+           arena = std::make_unique<std::pmr::monotonic_buffer_resource>(mm->tx_model_options().arena_initial_size);
+       }
+       model_text = std::make_shared<const std::string>(text);
        model_filename = filename;
        std::shared_ptr<textx::object::Object> parent = nullptr;
-       root = create_model(text, parsetree, *mm, parent);
+       root = create_model(*model_text, parsetree, *mm, parent); // string values are views into model_text
     }
 
     textx::object::Value Model::create_model(const std::string_view text, const textx::arpeggio::Match &m, textx::Metamodel &mm, std::shared_ptr<textx::object::Object> parent) {
@@ -19,7 +40,7 @@ namespace textx {
             auto &rule = mm[rule_name];
             if (rule.type() == RuleType::match) {
                 //std::cout << "match -*- " << m << "\n";
-                return {textx::object::MatchText{textx::arpeggio::get_str(text, m),rule_name},m.start()};
+                return {textx::object::MatchText{*model_text, textx::arpeggio::get_str(text, m), rule_name, *model_strings},m.start()};
             }
             if (rule.type() == RuleType::common) {
                 return create_model_from_common_rule(rule_name, text, m, mm, parent);
@@ -29,7 +50,7 @@ namespace textx {
             }
         }
         if (textx::arpeggio::is_terminal(m)) { // also a match
-            return {textx::object::MatchText{textx::arpeggio::get_str(text, m), "?"},m.start()};
+            return {textx::object::MatchText{*model_text, textx::arpeggio::get_str(text, m), "?", *model_strings},m.start()};
         }
         else {
             textx::arpeggio::raise(m.start(), "unexpected, no rule result found here to create object data...\n", m);
@@ -37,37 +58,42 @@ namespace textx {
     }
 
     textx::object::Value Model::create_model_from_common_rule(const std::string& rule_name, const std::string_view text, const textx::arpeggio::Match &m0, textx::Metamodel &mm, std::shared_ptr<textx::object::Object> parent) {
-        auto obj = std::make_shared<textx::object::Object>(parent, m0.start());
+        auto obj = create_object(parent, m0.start());
         obj->type = rule_name;
-        obj->weak_model = shared_from_this(); // store weak ptr
+        if (arena!=nullptr) {
+            obj->weak_model = std::shared_ptr<Model>(std::shared_ptr<Model>{}, this); // raw ptr (objects live in the model)
+        }
+        else {
+            obj->weak_model = shared_from_this(); // store weak ptr
+        }
 
         // create all fields with empty content
         const auto &rule = mm[rule_name];
-        for (auto &[attr_name,info]: rule.get_attribute_info()) {
+        obj->type_id = mm.type_id(rule);
+        obj->type_space = mm.tx_type_space();
+        obj->attributes.reset(rule.tx_attribute_layout());
+        size_t slot = 0;
+        for (auto &attr_name: rule.tx_attribute_names()) {
+            auto &info = rule[attr_name];
+            auto &attr = obj->attributes.at_slot(slot++);
             if (info.cardinality == AttributeCardinality::list) {
-                obj->create_attribute_if_not_present(attr_name);
                 //std::cout << "create list " << attr_name << "\n";
-                (*obj)[attr_name] = textx::object::AttributeValue{std::vector<textx::object::Value>{}};
+                attr = textx::object::AttributeValue{std::vector<textx::object::Value>{}};
             }
             else if (info.cardinality == AttributeCardinality::scalar) {
-                obj->create_attribute_if_not_present(attr_name);
                 //std::cout << "create scalar " << attr_name << " from " << m0 <<   "\n";
                 if (info.maybe_boolean()) {
-                    std::string t="";
-                    if (info.type.has_value()) {
-                        t = info.type.value();
-                    }
-                    (*obj)[attr_name] = textx::object::AttributeValue{textx::object::Value{false,m0.start()}};
+                    attr = textx::object::AttributeValue{textx::object::Value{false,m0.start()}};
                 }
                 else if (info.maybe_str()) {
                     std::string t="";
                     if (info.type.has_value()) {
                         t = info.type.value();
                     }
-                    (*obj)[attr_name] = textx::object::AttributeValue{textx::object::Value{textx::object::MatchText{"",t},m0.start()}};
+                    attr = textx::object::AttributeValue{textx::object::Value{textx::object::MatchText{"",t},m0.start()}};
                 }
                 else {
-                    (*obj)[attr_name] = textx::object::AttributeValue{textx::object::Value{std::shared_ptr<textx::object::Object>{}, m0.start()}};
+                    attr = textx::object::AttributeValue{textx::object::Value{std::shared_ptr<textx::object::Object>{}, m0.start()}};
                 }
             }
             else {
@@ -103,14 +129,16 @@ namespace textx {
                 // reference assignment
                 if (val.name_starts_with("obj_ref://")) {
                     TEXTX_ASSERT(mm[rule_name][attr_name].type.has_value(), rule_name, ".", attr_name, " must have a type");
-                    auto target_type = mm[rule_name][attr_name].type.value();
-                    std::string ref_name = std::string{textx::arpeggio::get_str(text, val.children[0])};
+                    auto ref_name = textx::arpeggio::get_str(text, val.children[0]); // view into the model text
+                    textx::object::ObjectRef ref{shared_from_this(), ref_name, obj};
+                    ref.rule_id = obj->type_id;
+                    ref.attr_id = static_cast<std::uint32_t>(rule.tx_attribute_id(attr_name));
 
                     if (mm[rule_name][attr_name].cardinality==AttributeCardinality::scalar) {
-                        (*obj)[attr_name].data = textx::object::Value{textx::object::ObjectRef{shared_from_this(), ref_name, rule_name, target_type, attr_name, obj}, val.start()};
+                        (*obj)[attr_name].data = textx::object::Value{std::move(ref), val.start()};
                     }
                     else {
-                        (*obj)[attr_name].append(textx::object::Value{textx::object::ObjectRef{shared_from_this(), ref_name, rule_name, target_type, attr_name, obj}, val.start()});
+                        (*obj)[attr_name].append(textx::object::Value{std::move(ref), val.start()});
                     }
                 }
                 else { // no reference
@@ -152,34 +180,221 @@ namespace textx {
         auto &r = traverse(m0,true);
         if(&r == &m0) {
             //std::cout << "abstract rule --> match -*- " << m << "\n";
-            return {textx::object::MatchText{textx::arpeggio::get_str(text, m0), rule_name},m0.start()};            
+            return {textx::object::MatchText{*model_text, textx::arpeggio::get_str(text, m0), rule_name, *model_strings},m0.start()};            
         }
         return create_model(text, r, mm, parent);
     }
 
-    size_t Model::resolve_references() {
+    std::tuple<std::shared_ptr<textx::object::Object>, textx::object::MatchedPath> Model::find_reference_target(const textx::object::ObjectRef& ref) const {
         auto mm = weak_mm.lock();
-        size_t unresolved=0;
-        textx::object::traverse(root,[&](textx::object::Value& v) -> void {
-            if (v.is_ref()) {
-                if (v.ref().obj.lock() == nullptr) {
-                    auto [obj, objpath] = mm->get_resolver(v.ref().rule, v.ref().attr)
-                        .resolve(v.ref().parent.lock(),v.ref().name, v.ref().target_type);
-                    v.ref().obj = obj;
-                    v.ref().objpath = std::move(objpath);
-                    if (v.ref().obj.lock() == nullptr) {
-                        unresolved++;
-                    }
-                }
+        auto &target_type = mm->tx_rule(ref.rule_id).tx_attribute_info(ref.attr_id).type.value();
+        return mm->get_resolver(ref.rule_id, ref.attr_id).resolve(ref.parent.lock(), std::string{ref.name}, target_type);
+    }
+
+    void Model::validate_all_references() {
+        auto models = get_all_referenced_models();
+        std::lock_guard lock{*lazy_resolution_mutex};
+        for (auto &m: models) {
+            for (auto &v: textx::object::tree(m->val())) {
+                if (v.is_ref()) v.ref().lazy.state = textx::object::LazyResolution::none; // eager from now on
             }
-        });
-        return unresolved;
+        }
+        auto mm = tx_metamodel();
+        TEXTX_ASSERT(mm!=nullptr);
+        Metamodel::resolve_references(models, mm->tx_model_options().resolver_threads);
+    }
+
+    void Model::add_importer(const std::shared_ptr<textx::Model>& m) {
+        std::lock_guard lock{importers_mutex};
+        if (weak_importers.size()==weak_importers.capacity()) { // before growing (amortized)
+            std::erase_if(weak_importers, [](auto &x) { return x.expired(); });
+        }
+        weak_importers.push_back(m);
+    }
+
+    void Model::remove_importer(const textx::Model* m) {
+        std::lock_guard lock{importers_mutex};
+        std::erase_if(weak_importers, [&](auto &x) { return x.expired() || x.lock().get()==m; });
+    }
+
+    std::vector<std::shared_ptr<textx::Model>> Model::tx_importers() {
+        std::lock_guard lock{importers_mutex};
+        std::vector<std::shared_ptr<textx::Model>> res;
+        for (auto &weak: weak_importers) {
+            if (auto m = weak.lock()) res.push_back(m);
+        }
+        return res;
     }
 
     std::shared_ptr<textx::object::Object> Model::fqn(std::string name) {
         return textx::scoping::dot_separated_name_search(val().obj(), name);
     }
 
+    const std::vector<std::shared_ptr<textx::object::Object>>& Model::all_of(std::string_view type) {
+        auto mm = weak_mm.lock();
+        TEXTX_ASSERT(mm!=nullptr);
+        return all_of(mm->type_id(std::string{type}));
+    }
+
+    const std::vector<std::shared_ptr<textx::object::Object>>& Model::all_of(textx::object::TypeId id) {
+        auto mm = weak_mm.lock();
+        TEXTX_ASSERT(mm!=nullptr);
+        std::lock_guard lock{type_index_mutex};
+        build_object_index();
+        auto [p, inserted] = objects_by_type.try_emplace(id);
+        if (inserted) {
+            for (auto &obj: all_objects) {
+                if (mm->is_instance(*obj, id)) {
+                    p->second.push_back(obj);
+                }
+            }
+        }
+        return p->second;
+    }
+
+    void Model::build_object_index() {
+        if (!type_index_valid) {
+            for (auto p=textx::object::objects(val()).begin(); p!=std::default_sentinel; ++p) {
+                all_objects.push_back(p.value().obj());
+            }
+            type_index_valid = true;
+        }
+    }
+
+    const std::vector<std::shared_ptr<textx::object::Object>>& Model::objects_named(std::string_view name) {
+        static const std::vector<std::shared_ptr<textx::object::Object>> none;
+        std::lock_guard lock{type_index_mutex};
+        if (!name_index_valid) {
+            build_object_index();
+            for (auto &obj: all_objects) {
+                if (!obj->has_attr("name")) continue;
+                auto &attr = (*obj)["name"];
+                if (attr.is_str()) {
+                    objects_by_name[attr.str_view()].push_back(obj);
+                }
+            }
+            name_index_valid = true;
+        }
+        auto p = objects_by_name.find(name);
+        return p==objects_by_name.end() ? none : p->second;
+    }
+
+    std::vector<std::shared_ptr<textx::object::Object>> Model::all_of_including_imports(std::string_view type) {
+        std::vector<std::shared_ptr<textx::Model>> models = { shared_from_this() };
+        for (size_t i=0;i<models.size();i++) {
+            for (auto &weak_other: models[i]->tx_imported_models()) {
+                auto other = weak_other.lock();
+                TEXTX_ASSERT(other != nullptr);
+                if (std::find(models.begin(), models.end(), other)==models.end()) {
+                    models.push_back(other);
+                }
+            }
+        }
+        const Rule* rule = (type=="OBJECT") ? nullptr : &tx_metamodel()->find_rule(type, true); // the name is looked up in this metamodel
+        std::vector<std::shared_ptr<textx::object::Object>> res;
+        for (auto &m: models) {
+            auto mm = m->tx_metamodel();
+            if (rule!=nullptr && !mm->has_type_id(*rule)) continue; // e.g. model of another language
+            auto &objects = m->all_of(rule==nullptr ? 0 : mm->type_id(*rule));
+            res.insert(res.end(), objects.begin(), objects.end());
+        }
+        return res;
+    }
+
+    void Model::reset_type_index() {
+        {
+            std::lock_guard lock{type_index_mutex};
+            type_index_valid = false;
+            all_objects.clear();
+            objects_by_type.clear();
+            name_index_valid = false;
+            objects_by_name.clear();
+            for (auto &obj: textx::object::objects(val())) {
+                obj.reset_child_names();
+            }
+            if (scope_cache!=nullptr) {
+                scope_cache->clear();
+            }
+        }
+        if (auto workspace = tx_workspace()) {
+            workspace->tx_exported_symbols().update(shared_from_this()); // w/o type_index_mutex (lookups lock it)
+        }
+    }
+
+    MemoryStats Model::tx_memory_stats() {
+        constexpr size_t control_block = 2*sizeof(void*); // of make_shared (reference counters)
+        MemoryStats stats = parse_stats;
+        stats.strings.add(control_block+sizeof(std::string));
+        stats.strings.add(*model_text);
+        stats.strings.add(model_filename);
+
+        stats.strings.add(control_block+sizeof(std::deque<std::string>));
+        for (auto &s: *model_strings) {
+            stats.strings.add(sizeof(std::string), 0); // in the chunks of the deque
+            stats.strings.add(s);
+        }
+        auto add_value = [&](const textx::object::Value& v) {
+            if (auto text = std::get_if<textx::object::MatchText>(&v.data); text!=nullptr && text->owns_text) {
+                stats.strings.add(sizeof(std::string));
+                stats.strings.add(*text->range.source);
+            }
+            else if (auto ref = std::get_if<textx::object::ObjectRef>(&v.data)) {
+                stats.references.add(ref->objpath); // the name is a view into the model text
+            }
+        };
+        std::unordered_set<const textx::object::AttributeLayout*> extended_layouts; // the rule layouts belong to the metamodel
+        for (auto &obj: textx::object::objects(val())) {
+            if (arena==nullptr) {
+                stats.objects.add(control_block+sizeof(textx::object::Object));
+            }
+            else {
+                stats.objects.add(sizeof(textx::object::Object), 0); // allocated in arena chunks
+            }
+            stats.strings.add(obj.type);
+            if (auto names = obj.tx_child_names_if_built()) {
+                stats.objects.add(sizeof(textx::object::ChildNames)+2*sizeof(void*));
+                stats.objects += names->memory_usage();
+            }
+            if (obj.attributes.size()>0) {
+                stats.objects.add(obj.attributes.size()*sizeof(textx::object::AttributeValue), (arena==nullptr)?1:0);
+            }
+            auto &layout = *obj.attributes.layout();
+            if (layout.base!=nullptr && extended_layouts.insert(&layout).second) {
+                stats.objects.add(control_block+sizeof(textx::object::AttributeLayout));
+                stats.objects.add(layout.names);
+                for (auto &name: layout.names) stats.objects.add(name);
+                stats.objects.add(layout.slots_by_name);
+            }
+            for (auto &[name, attr]: obj.attributes) {
+                if (attr.is_list()) {
+                    auto &values = std::get<std::vector<textx::object::Value>>(attr.data);
+                    stats.objects.add(values);
+                    for (auto &v: values) add_value(v);
+                }
+                else {
+                    add_value(std::get<textx::object::Value>(attr.data));
+                }
+            }
+        }
+        stats.objects.add(arena_objects);
+        stats.objects.add(weak_imported_models);
+        {
+            std::lock_guard lock{importers_mutex};
+            stats.objects.add(weak_importers);
+        }
+        std::lock_guard lock{type_index_mutex};
+        stats.objects.add(all_objects);
+        for (auto &[id, objects]: objects_by_type) {
+            stats.objects.add(sizeof(std::pair<const textx::object::TypeId, std::vector<std::shared_ptr<textx::object::Object>>>)+sizeof(void*));
+            stats.objects.add(objects);
+        }
+        for (auto &[name, objects]: objects_by_name) {
+            stats.objects.add(sizeof(std::pair<const std::string_view, std::vector<std::shared_ptr<textx::object::Object>>>)+2*sizeof(void*));
+            stats.objects.add(objects);
+        }
+        return stats;
+    }
+
     std::unordered_set<std::shared_ptr<textx::Model>> Model::get_all_referenced_models() {
         std::unordered_set<std::shared_ptr<textx::Model>> res={ shared_from_this() };
         size_t n{res.size()}, n_old{};
@@ -198,4 +413,38 @@ namespace textx {
     }
 
 
-}
\ No newline at end of file
+}
+
+namespace textx::object {
+    constinit thread_local StagedResolution* StagedResolution::current = nullptr;
+
+    std::shared_ptr<Object> resolve_lazily(const ObjectRef& ref) {
+        if (auto staged = StagedResolution::current) {
+            auto p = staged->refs.find(&ref);
+            if (p!=staged->refs.end()) return p->second.obj.lock();
+            if (ref.lazy.state.load(std::memory_order_acquire)==LazyResolution::none) return ref.obj.lock();
+        }
+        auto outer = std::exchange(StagedResolution::current, nullptr); // lazy references of published models are resolved as published
+        struct Restore {
+            StagedResolution* outer;
+            ~Restore() { StagedResolution::current = outer; }
+        } restore{outer};
+        auto m = ref.tx_model.lock();
+        TEXTX_ASSERT(m!=nullptr, "reference '", ref.name, "' without model");
+        std::lock_guard lock{*m->lazy_resolution_mutex}; // once per reference (the state is checked again)
+        if (ref.lazy.state.load()==LazyResolution::pending) {
+            ref.lazy.state = LazyResolution::in_progress; // cycles: nested accesses see an unresolved reference
+            try {
+                auto [obj, objpath] = m->find_reference_target(ref);
+                ref.obj = obj;
+                ref.objpath = std::move(objpath);
+            }
+            catch (...) {
+                ref.lazy.state = LazyResolution::pending;
+                throw;
+            }
+            ref.lazy.state.store(LazyResolution::none, std::memory_order_release);
+        }
+        return ref.obj.lock();
+    }
+}
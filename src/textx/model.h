@@ -1,12 +1,71 @@
 #pragma once
 #include "textx/object.h"
 #include "textx/rule.h"
+#include "textx/memory_stats.h"
+#include "textx/scope_cache.h"
 #include <memory>
+#include <memory_resource>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace textx::frozen {
+    class FrozenModel;
+}
+
+namespace textx {
+    class Workspace;
+}
 
 namespace textx {
 
+    struct ModelOptions {
+        /**
+         * Allocate the objects of a model and their attribute slots in a model
+         * owned arena (lists of values, type names and the matched paths of
+         * references still use the heap). Parent, model and reference links
+         * are raw pointers then and all shared_ptr<Object> handed out are
+         * non-owning (no reference counting): they must not be used after the
+         * model is destroyed.
+         */
+        bool use_arena = false;
+        size_t arena_initial_size = 64*1024;
+        /** measure the parser memory (memo tables and parse tree) of each model (see Model::tx_memory_stats) */
+        bool collect_parse_memory_stats = false;
+        /**
+         * Threads to resolve references (0: one per core). With more than one
+         * thread all resolvers must be thread-safe (the builtin resolvers are).
+         * The results do not depend on the number of threads.
+         */
+        size_t resolver_threads = 1;
+        /**
+         * Threads to load the imported models (importURI) of a model (0: one
+         * per core). The import graph is loaded level by level (each file is
+         * parsed once) and linked before references are resolved; the
+         * resulting models do not depend on the number of threads.
+         */
+        size_t import_threads = 1;
+        /**
+         * Cache the results of the RREL and FQN scope searches per model
+         * (see textx/scope_cache.h and Model::tx_scope_cache).
+         */
+        bool cache_scope_results = false;
+        /**
+         * Do not resolve the references when loading a model: each reference
+         * is resolved on its first access (ObjectRef::target, Value::obj),
+         * unresolvable references stay nullptr. Model::validate_all_references
+         * resolves all of them with the errors of the eager resolution.
+         */
+        bool lazy_references = false;
+    };
+
     class Model : public std::enable_shared_from_this<Model> {
         std::weak_ptr<Metamodel> weak_mm;
+        std::weak_ptr<Workspace> weak_workspace; // the workspace which loaded the model (see Workspace::tx_exported_symbols)
+        std::shared_ptr<std::recursive_mutex> lazy_resolution_mutex = std::make_shared<std::recursive_mutex>(); // of the workspace (see Workspace::tx_lazy_resolution_mutex)
+        std::unique_ptr<std::pmr::monotonic_buffer_resource> arena = nullptr; // see ModelOptions::use_arena
+        std::vector<textx::object::Object*> arena_objects = {};
+        std::shared_ptr<textx::object::Object> create_object(std::shared_ptr<textx::object::Object> parent, textx::arpeggio::TextPosition pos);
         textx::object::Value root={std::shared_ptr<textx::object::Object>{},{}}; // nullptr
         textx::object::Value create_model(const std::string_view text, const textx::arpeggio::Match &m, textx::Metamodel &mm, std::shared_ptr<textx::object::Object> parent);
         textx::object::Value create_model_from_common_rule(const std::string& rule_name, const std::string_view text, const textx::arpeggio::Match &m0, textx::Metamodel &mm, std::shared_ptr<textx::object::Object> parent);
@@ -14,28 +73,75 @@ namespace textx {
         Model() = default;
         void init(const std::string_view filename, const std::string_view text, const textx::arpeggio::Match &parsetree, std::shared_ptr<Metamodel> mm);
         std::vector<std::weak_ptr<textx::Model>> weak_imported_models;
-        std::string model_text={};
+        std::mutex importers_mutex; // imports of different models are linked concurrently (e.g., the builtin models)
+        std::vector<std::weak_ptr<textx::Model>> weak_importers = {}; // the models importing this one (see add_imported_model)
+        void add_importer(const std::shared_ptr<textx::Model>& m);
+        void remove_importer(const textx::Model* m);
+        std::shared_ptr<const std::string> model_text = std::make_shared<const std::string>(); // viewed by the string values (see MatchText, shared with frozen snapshots)
+        std::shared_ptr<std::deque<std::string>> model_strings = std::make_shared<std::deque<std::string>>(); // unescaped STRING values (see MatchText, shared with frozen snapshots)
         std::string model_filename={};
+        MemoryStats parse_stats = {}; // see ModelOptions::collect_parse_memory_stats
+        std::unique_ptr<textx::scoping::ScopeCache> scope_cache = nullptr; // see ModelOptions::cache_scope_results
+
+        // objects of the model in traversal order and per type incl. subtypes (see all_of)
+        std::mutex type_index_mutex;
+        bool type_index_valid = false;
+        std::vector<std::shared_ptr<textx::object::Object>> all_objects = {};
+        std::unordered_map<textx::object::TypeId, std::vector<std::shared_ptr<textx::object::Object>>> objects_by_type = {};
+        const std::vector<std::shared_ptr<textx::object::Object>>& all_of(textx::object::TypeId id);
+        void build_object_index(); // all_objects (type_index_mutex must be locked)
+        // objects with a text attribute "name" in traversal order (keys are views into the values)
+        bool name_index_valid = false;
+        std::unordered_map<std::string_view, std::vector<std::shared_ptr<textx::object::Object>>> objects_by_name = {};
         
-        /** return the number of unresolved refs */
-        size_t resolve_references();
+        /** looks up the target of a reference of this model (w/o modifying the model) */
+        std::tuple<std::shared_ptr<textx::object::Object>, textx::object::MatchedPath> find_reference_target(const textx::object::ObjectRef& ref) const;
         friend textx::Metamodel;
+        friend textx::frozen::FrozenModel;
+        friend std::shared_ptr<textx::object::Object> textx::object::resolve_lazily(const textx::object::ObjectRef& ref);
     public:
+        ~Model();
+        Model(const Model&) = delete;
+        Model& operator=(const Model&) = delete;
+        bool tx_uses_arena() const { return arena!=nullptr; }
+        size_t tx_arena_object_count() const { return arena_objects.size(); }
         void set_filename_info(std::string f) { model_filename=f; }
         std::shared_ptr<textx::Metamodel> tx_metamodel() const { return weak_mm.lock(); }
+        std::shared_ptr<textx::Workspace> tx_workspace() const { return weak_workspace.lock(); }
         textx::object::Value& val() { 
             return root;
         }
-        const auto& tx_imported_models() const { return weak_imported_models; }
+        /** the imported models (staged imports while a refresh resolves the references, see StagedResolution) */
+        const std::vector<std::weak_ptr<textx::Model>>& tx_imported_models() const {
+            if (auto staged = textx::object::StagedResolution::current) {
+                auto p = staged->imports.find(this);
+                if (p!=staged->imports.end()) return p->second;
+            }
+            return weak_imported_models;
+        }
+        /** the (living) models which import this one, in the order the imports were linked */
+        std::vector<std::shared_ptr<textx::Model>> tx_importers();
         void add_imported_model(std::shared_ptr<textx::Model> im) { 
             if (std::find_if(weak_imported_models.begin(), weak_imported_models.end(), [&](auto &x){
                 return x.lock() == im;
             })==weak_imported_models.end()) {
                 weak_imported_models.push_back(im);
+                im->add_importer(shared_from_this());
             }
         }
 
-        const std::string& tx_text() { return model_text; };
+        /** replaces the link to an imported model (same position in the import order, see Workspace::refresh) */
+        void replace_imported_model(const std::shared_ptr<textx::Model>& old_model, const std::shared_ptr<textx::Model>& new_model) {
+            for (auto &im: weak_imported_models) {
+                if (im.lock()==old_model) {
+                    im = new_model;
+                    old_model->remove_importer(this);
+                    new_model->add_importer(shared_from_this());
+                }
+            }
+        }
+
+        const std::string& tx_text() { return *model_text; };
         const std::string& tx_filename() { return model_filename; };
        
         const textx::object::Value& val() const {
@@ -57,8 +163,49 @@ namespace textx {
         const textx::object::AttributeValue& operator[](std::string name) const { return val()[name]; }
         textx::object::AttributeValue& operator[](std::string name) { return val()[name]; }
         std::shared_ptr<textx::object::Object> fqn(std::string name);
-        textx::object::AttributeValue fqn_attributes(std::string name) { return val().obj()->fqn_attributes(name); }
+        textx::object::AttributeValue fqn_attributes(std::string_view name) { return val().obj()->fqn_attributes(name); }
+        textx::object::PathQuery::Result query(const textx::object::PathQuery& q) { return q(*val().obj()); }
 
         std::unordered_set<std::shared_ptr<textx::Model>> get_all_referenced_models();
+
+        /**
+         * all objects of a rule (incl. derived rules) in traversal order.
+         * The index is built on first use (call reset_type_index after modifying the model).
+         */
+        const std::vector<std::shared_ptr<textx::object::Object>>& all_of(std::string_view type);
+        /** all_of for this model and all (transitively) imported models */
+        std::vector<std::shared_ptr<textx::object::Object>> all_of_including_imports(std::string_view type);
+        /**
+         * all objects with a text attribute "name" equal to name (in traversal order).
+         * The index is built on first use (call reset_type_index after modifying the model).
+         */
+        const std::vector<std::shared_ptr<textx::object::Object>>& objects_named(std::string_view name);
+        /**
+         * resets the type and the name index, the child name indices of the
+         * objects (see Object::child_names), the scope cache and the exported
+         * names of the model in its workspace
+         */
+        void reset_type_index();
+        /**
+         * resolves all references of this and the imported models which are
+         * still pending (see ModelOptions::lazy_references) and throws for
+         * unresolvable ones (not concurrently with other accesses of the models).
+         */
+        void validate_all_references();
+        /** the scope cache (nullptr w/o ModelOptions::cache_scope_results or while a refresh resolves the references again) */
+        textx::scoping::ScopeCache* tx_scope_cache() const {
+            auto staged = textx::object::StagedResolution::current;
+            if (staged!=nullptr && staged->imports.count(this)>0) return nullptr; // not filled with staged results
+            return scope_cache.get();
+        }
+
+        /**
+         * memory of the model (w/o imported models and the metamodel).
+         * The parser memory is only reported with ModelOptions::collect_parse_memory_stats.
+         */
+        MemoryStats tx_memory_stats();
+
+        /** immutable snapshot of this and all imported models for concurrent reads (see textx/frozen.h) */
+        std::shared_ptr<const textx::frozen::FrozenModel> freeze();
     };
 }
\ No newline at end of file
@@ -1,19 +1,208 @@
 #include "textx/object.h"
 #include "textx/metamodel.h"
+#include "textx/utils.h"
+#include <charconv>
+#include <limits>
+#include <algorithm>
+#include <mutex>
+#include <unordered_set>
+#include <deque>
 
 namespace textx::object {
 
-    const AttributeValue& Value::operator[](std::string name) const {
+    TextType text_type_of_rule(std::string_view rule_name) {
+        if (rule_name=="ID") return TextType::ID;
+        if (rule_name=="BOOL") return TextType::BOOL;
+        if (rule_name=="INT") return TextType::INT;
+        if (rule_name=="FLOAT") return TextType::FLOAT;
+        if (rule_name=="STRICTFLOAT") return TextType::STRICTFLOAT;
+        if (rule_name=="NUMBER") return TextType::NUMBER;
+        if (rule_name=="STRING") return TextType::STRING;
+        return TextType::other;
+    }
+
+    const std::string& intern(std::string_view s) {
+        static std::mutex mutex;
+        static std::unordered_set<std::string, textx::utils::string_hash, std::equal_to<>> pool;
+        std::lock_guard lock{mutex};
+        auto p = pool.find(s);
+        if (p==pool.end()) {
+            p = pool.emplace(s).first;
+        }
+        return *p;
+    }
+
+    namespace {
+        // rule names of MatchText (the index is stored)
+        struct RuleNames {
+            std::mutex mutex;
+            std::vector<const std::string*> names = {};
+            std::unordered_map<std::string_view, std::uint32_t> ids = {};
+        };
+        RuleNames& rule_names() {
+            static RuleNames rule_names;
+            return rule_names;
+        }
+
+        std::uint32_t rule_name_id(std::string_view rule) {
+            auto &r = rule_names();
+            std::lock_guard lock{r.mutex};
+            auto p = r.ids.find(rule);
+            if (p==r.ids.end()) {
+                auto &name = intern(rule);
+                p = r.ids.emplace(name, static_cast<std::uint32_t>(r.names.size())).first;
+                r.names.push_back(&name);
+            }
+            return p->second;
+        }
+
+        std::string unescape(std::string_view text) {
+            std::string res;
+            res.reserve(text.size());
+            for (size_t i=0;i<text.size();i++) {
+                if (text[i]=='\\' && i+1<text.size()) {
+                    switch (text[i+1]) {
+                        case '"': case '\'': case '\\': res += text[++i]; continue;
+                        case 'n': res += '\n'; i++; continue;
+                        case 't': res += '\t'; i++; continue;
+                        case 'r': res += '\r'; i++; continue;
+                        default: break; // kept as is
+                    }
+                }
+                res += text[i];
+            }
+            return res;
+        }
+    }
+
+    MatchText::MatchText(std::string_view text, std::string_view rule) : rule_name{rule_name_id(rule)}, type{text_type_of_rule(rule)} {
+        if (text.empty()) return; // e.g., unset attributes (no copy)
+        std::string copy{text};
+        std::deque<std::string> unescaped;
+        init(copy, copy, unescaped);
+        range.source = new std::string(std::move(unescaped.empty() ? copy : unescaped.front())); // same offset
+        owns_text = true;
+    }
+
+    MatchText::MatchText(const std::string& source, std::string_view text, std::string_view rule, std::deque<std::string>& strings) : rule_name{rule_name_id(rule)}, type{text_type_of_rule(rule)} {
+        init(source, text, strings);
+    }
+
+    MatchText::MatchText(const MatchText& other) : range{other.range}, rule_name{other.rule_name}, type{other.type}, scalar{other.scalar}, owns_text{other.owns_text} {
+        copy_scalar(other);
+        if (owns_text) range.source = new std::string(*other.range.source);
+    }
+
+    MatchText::MatchText(MatchText&& other) noexcept : range{other.range}, rule_name{other.rule_name}, type{other.type}, scalar{other.scalar}, owns_text{other.owns_text} {
+        copy_scalar(other);
+        other.range = {};
+        other.owns_text = false;
+    }
+
+    MatchText& MatchText::operator=(const MatchText& other) {
+        if (this!=&other) {
+            *this = MatchText{other};
+        }
+        return *this;
+    }
+
+    MatchText& MatchText::operator=(MatchText&& other) noexcept {
+        if (this!=&other) {
+            if (owns_text) delete range.source;
+            range = other.range;
+            rule_name = other.rule_name;
+            type = other.type;
+            scalar = other.scalar;
+            owns_text = other.owns_text;
+            copy_scalar(other);
+            other.range = {};
+            other.owns_text = false;
+        }
+        return *this;
+    }
+
+    MatchText::~MatchText() {
+        if (owns_text) delete range.source;
+    }
+
+    void MatchText::copy_scalar(const MatchText& other) {
+        switch (other.scalar) {
+            case Scalar::integer: int_value = other.int_value; break;
+            case Scalar::floating: float_value = other.float_value; break;
+            case Scalar::boolean: bool_value = other.bool_value; break;
+            case Scalar::none: break;
+        }
+    }
+
+    void MatchText::init(const std::string& source, std::string_view text, std::deque<std::string>& strings) {
+        const std::string* owner = &source;
+        if (type==TextType::STRING && text.size()>=2 && (text.front()=='"' || text.front()=='\'') && text.back()==text.front()) {
+            text = text.substr(1, text.size()-2);
+            if (text.find('\\')!=text.npos) {
+                owner = &strings.emplace_back(unescape(text));
+                text = *owner;
+            }
+        }
+        TEXTX_ASSERT(text.data()>=owner->data() && text.data()+text.size()<=owner->data()+owner->size(), "text must be a part of its source");
+        TEXTX_ASSERT(owner->size()<=std::numeric_limits<std::uint32_t>::max(), "text too large");
+        range = {owner, static_cast<std::uint32_t>(text.data()-owner->data()), static_cast<std::uint32_t>(text.size())};
+        if (is_number() || type==TextType::BOOL) convert_scalar();
+    }
+
+    std::string_view MatchText::rule() const {
+        auto &r = rule_names();
+        std::lock_guard lock{r.mutex};
+        return *r.names[rule_name];
+    }
+
+    void MatchText::convert_scalar() {
+        auto t = text();
+        if (type==TextType::BOOL) {
+            if (t=="true" || t=="True" || t=="1") { bool_value = true; scalar = Scalar::boolean; }
+            else if (t=="false" || t=="False" || t=="0") { bool_value = false; scalar = Scalar::boolean; }
+            return;
+        }
+        // Integers are only converted where from_chars gives exactly the result of
+        // std::stoll(text, nullptr, 0); everything else (e.g. octal/hex prefixes,
+        // errors) is left to i()/f().
+        const char* begin = t.data();
+        const char* end = t.data()+t.size();
+        const char* p = (begin<end && *begin=='+') ? begin+1 : begin; // from_chars does not accept '+'
+        if (p==end || (p!=begin && (*p=='+' || *p=='-'))) return;
+        const char* digits = (*p=='-') ? p+1 : p;
+        if (type!=TextType::FLOAT && type!=TextType::STRICTFLOAT && digits<end && *digits>='0' && *digits<='9') {
+            bool octal_or_hex = (*digits=='0' && digits+1<end && ((digits[1]>='0' && digits[1]<='9') || digits[1]=='x' || digits[1]=='X'));
+            if (!octal_or_hex) {
+                std::int64_t i;
+                auto [ptr, ec] = std::from_chars(p, end, i);
+                if (ec==std::errc{} && ptr==end) {
+                    int_value = i;
+                    scalar = Scalar::integer;
+                    return;
+                }
+            }
+        }
+        if (std::all_of(begin, end, [](char c) { return (c>='0' && c<='9') || c=='+' || c=='-' || c=='.' || c=='e' || c=='E'; })) {
+            double f;
+            auto [ptr, ec] = std::from_chars(p, end, f);
+            if (ec==std::errc{}) {
+                float_value = f;
+                scalar = Scalar::floating;
+            }
+        }
+    }
+
+    const AttributeValue& Value::operator[](std::string_view name) const {
         return (*obj())[name];
     }
-    AttributeValue& Value::operator[](std::string name) {
+    AttributeValue& Value::operator[](std::string_view name) {
         return (*obj())[name];
     }
 
-    const AttributeValue& AttributeValue::operator[](std::string name) const {
+    const AttributeValue& AttributeValue::operator[](std::string_view name) const {
         return (*obj())[name];
     }
-    AttributeValue& AttributeValue::operator[](std::string name) {
+    AttributeValue& AttributeValue::operator[](std::string_view name) {
         return (*obj())[name];
     }
 
@@ -51,64 +240,185 @@ namespace textx::object {
     }
 
     bool Object::is_instance(std::string base) {
-        return tx_model()->tx_metamodel()->is_instance(type, base);
+        auto mm = tx_model()->tx_metamodel();
+        return mm->is_instance(*this, mm->type_id(base));
     }
 
-    namespace {
-        auto extract_array_index(std::string name) {
-            auto pos=name.find('[');
-            std::optional<size_t> array_index=std::nullopt;
-            if (pos!=std::string::npos) {
-                TEXTX_ASSERT(name[name.size()-1]==']', " syntax error in array access attr[idx]: ", name);
-                array_index = std::stoul(name.substr(pos+1,name.size()-pos-2));
-                name = name.substr(0,pos);
-            }
-            return std::make_pair(name, array_index);
+    AttributeValue& Attributes::insert(std::string_view name) {
+        auto slot = m_layout->slot(name);
+        if (slot.has_value()) {
+            return values[slot.value()];
         }
+        m_layout = AttributeLayout::extended(m_layout, name);
+        values.emplace_back();
+        return values.back();
     }
 
-    const AttributeValue& Object::operator[](std::string name) const {
-        auto r = attributes.find(name);
-        if (r==attributes.end()) {
-            throw std::runtime_error(std::string("attribute ")+name+" not found.");
+    std::shared_ptr<const AttributeLayout> AttributeLayout::extended(const std::shared_ptr<const AttributeLayout>& layout, std::string_view name) {
+        std::lock_guard lock{layout->extensions_mutex};
+        auto &known = layout->extensions[std::string{name}];
+        auto res = known.lock();
+        if (res==nullptr) {
+            auto names = layout->names;
+            names.emplace_back(name);
+            auto extension = std::make_shared<AttributeLayout>(std::move(names));
+            extension->base = layout;
+            res = extension;
+            known = res;
         }
-        return r->second;
+        return res;
+    }
+
+    const AttributeValue& Object::operator[](std::string_view name) const {
+        auto slot = attributes.layout()->slot(name);
+        if (!slot.has_value()) {
+            throw std::runtime_error(std::string("attribute ")+std::string{name}+" not found.");
+        }
+        return attributes.at_slot(slot.value());
     }
     
-    AttributeValue& Object::operator[](std::string name) {
-        auto r = attributes.find(name);
-        if (r==attributes.end()) {
-            throw std::runtime_error(std::string("attribute ")+name+" not found.");
+    AttributeValue& Object::operator[](std::string_view name) {
+        auto slot = attributes.layout()->slot(name);
+        if (!slot.has_value()) {
+            throw std::runtime_error(std::string("attribute ")+std::string{name}+" not found.");
+        }
+        return attributes.at_slot(slot.value());
+    }
+
+    AttrKey Object::attr_key(std::string_view name) const {
+        auto slot = attributes.layout()->slot(name);
+        if (!slot.has_value()) {
+            throw std::runtime_error(std::string("attribute ")+std::string{name}+" not found.");
+        }
+        return AttrKey{attributes.layout().get(), slot.value()};
+    }
+
+    AttributeValue Object::fqn_attributes(std::string_view name) const {
+        auto res = PathQuery{name}(*this);
+        if (res.element!=nullptr) {
+            return AttributeValue{*res.element};
         }
-        return r->second;
+        return *res.attribute;
     }
 
-    AttributeValue Object::fqn_attributes(std::string name) const {
-        size_t pos = name.find('.');
-        if (pos==name.npos) {
-            auto [the_name, idx] = extract_array_index(name);
-            if (idx.has_value()) {
-                return AttributeValue{this->operator[](the_name)[idx.value()]};
+    PathQuery::PathQuery(std::string_view path) {
+        while (true) {
+            auto pos = path.find('.');
+            auto part = path.substr(0, pos);
+            Step step;
+            auto idx_pos = part.find('[');
+            if (idx_pos!=part.npos) {
+                TEXTX_ASSERT(part.back()==']', " syntax error in array access attr[idx]: ", part);
+                step.index = std::stoul(std::string{part.substr(idx_pos+1, part.size()-idx_pos-2)});
+                part = part.substr(0, idx_pos);
             }
-            else {
-                return this->operator[](the_name);
+            step.name = part;
+            steps.push_back(std::move(step));
+            if (pos==path.npos) break;
+            path = path.substr(pos+1);
+        }
+    }
+
+    namespace {
+        template<class R, class O>
+        R evaluate_path(O* obj, const auto& steps) {
+            R res;
+            for (size_t i=0;i<steps.size();i++) {
+                auto &step = steps[i];
+                res.attribute = &(*obj)[step.name];
+                res.element = step.index.has_value() ? &(*res.attribute)[step.index.value()] : nullptr;
+                if (i+1<steps.size()) {
+                    obj = (res.element!=nullptr) ? res.element->obj().get() : res.attribute->obj().get();
+                    TEXTX_ASSERT(obj!=nullptr, "null object in path at ", step.name);
+                }
             }
+            return res;
         }
-        else {
-            auto [the_name, idx] = extract_array_index(name.substr(0,pos));
-            if (idx.has_value()) {
-                return AttributeValue{this->operator[](the_name)[idx.value()].obj()->fqn_attributes(name.substr(pos+1))};
+    }
+
+    PathQuery::Result PathQuery::operator()(Object& obj) const {
+        return evaluate_path<Result>(&obj, steps);
+    }
+
+    PathQuery::ConstResult PathQuery::operator()(const Object& obj) const {
+        return evaluate_path<ConstResult>(&obj, steps);
+    }
+
+    ChildNames::ChildNames(const Object& obj) {
+        std::unordered_map<std::string_view, std::uint32_t> last;
+        auto add = [&](const Value& v) {
+            if (!v.is_pure_obj() || v.is_null()) return;
+            auto child = std::const_pointer_cast<Object>(v.obj()); // the children of a const object are handed out for lookups
+            if (!child->has_attr("name") || !(*child)["name"].is_str()) return;
+            auto idx = static_cast<std::uint32_t>(children.size());
+            children.push_back(child);
+            next.push_back(npos);
+            auto name = (*child)["name"].str_view();
+            auto [p, inserted] = last.try_emplace(name, idx);
+            if (inserted) {
+                first.emplace(name, idx);
             }
             else {
-                return this->operator[](the_name).obj()->fqn_attributes(name.substr(pos+1));
+                next[p->second] = idx;
+                p->second = idx;
+            }
+        };
+        for (auto& [name, attr]: obj.attributes) {
+            if (attr.is_list()) {
+                for (auto &v: std::get<std::vector<Value>>(attr.data)) add(v);
+            }
+            else {
+                add(std::get<Value>(attr.data));
+            }
+        }
+    }
+
+    namespace {
+        // moves the contained objects of obj (which is about to be destroyed) to pending
+        void release_contained_objects(Object& obj, std::vector<std::shared_ptr<Object>>& pending) {
+            obj.reset_child_names(); // the index also owns the children
+            auto take = [&](Value& v) {
+                auto p = std::get_if<std::shared_ptr<Object>>(&v.data);
+                if (p!=nullptr && p->use_count()>0) pending.push_back(std::move(*p)); // not for arena objects (non-owning)
+            };
+            for (size_t slot=0;slot<obj.attributes.size();slot++) {
+                auto &attr = obj.attributes.at_slot(slot);
+                if (auto v = std::get_if<Value>(&attr.data)) {
+                    take(*v);
+                }
+                else {
+                    for (auto &v: std::get<std::vector<Value>>(attr.data)) take(v);
+                }
+            }
+        }
+    }
+
+    Object::~Object() {
+        std::vector<std::shared_ptr<Object>> pending;
+        release_contained_objects(*this, pending);
+        while (!pending.empty()) {
+            auto obj = std::move(pending.back());
+            pending.pop_back();
+            if (obj.use_count()==1) {
+                release_contained_objects(*obj, pending); // obj is destroyed w/o contained objects below
             }
         }
     }
 
-    void Object::create_attribute_if_not_present(std::string name) {
-        if (attributes.count(name)==0) {
-            attributes[name]={};
+    std::shared_ptr<const ChildNames> Object::child_names() const {
+        auto names = child_names_index.load();
+        if (names==nullptr) {
+            auto created = std::make_shared<const ChildNames>(*this);
+            // another thread may have been faster (names is updated then):
+            if (child_names_index.compare_exchange_strong(names, created)) {
+                names = created;
+            }
         }
+        return names;
+    }
+
+    void Object::create_attribute_if_not_present(std::string_view name) {
+        attributes.insert(name);
     }
 
     void Value::print(std::ostream& o, size_t indent, bool one_line) const {
@@ -132,7 +442,7 @@ namespace textx::object {
         }
         else if (is_ref()) {
             if (!one_line) o << std::string(indent,' ');
-            o << "-[ref]->" << ref().name << "(" << ref().obj.lock() << ")";
+            o << "-[ref]->" << ref().name << "(" << ref().obj.lock() << ")"; // w/o lazy resolution
             if (!one_line) o << "\n";
         }
         else if (is_boolean()) {
@@ -153,12 +463,12 @@ namespace textx::object {
             if (!one_line) o << std::string(indent+2,' ');
             o << name << "=";
             if (!one_line) o <<"\n";
-            if (std::holds_alternative<Value>((*this)[name].data)) {
-                std::get<Value>((*this)[name].data).print(o,indent+4, one_line);
+            if (std::holds_alternative<Value>(a.data)) {
+                std::get<Value>(a.data).print(o,indent+4, one_line);
             }
             else { // array
-                for(size_t i=0;i<(*this)[name].size();i++) {
-                    (*this)[name][i].print(o,indent+4, one_line);
+                for(size_t i=0;i<a.size();i++) {
+                    a[i].print(o,indent+4, one_line);
                 }
             }
         }
@@ -167,4 +477,92 @@ namespace textx::object {
         if (!one_line) o << "\n";
     }
 
+
+    TreeIterator& TreeIterator::operator++() {
+        if (auto obj = contained_object(*current); obj!=nullptr && descend) {
+            stack.push_back({obj, 0, 0});
+        }
+        descend = true;
+        current = nullptr;
+        while (!stack.empty()) {
+            auto &f = stack.back();
+            if (f.slot<f.obj->attributes.size()) {
+                auto &av = f.obj->attributes.at_slot(f.slot);
+                if (auto v = std::get_if<Value>(&av.data)) {
+                    f.slot++;
+                    current = v;
+                    return *this;
+                }
+                auto &list = std::get<std::vector<Value>>(av.data);
+                if (f.index<list.size()) {
+                    current = &list[f.index++];
+                    return *this;
+                }
+                f.slot++;
+                f.index = 0;
+            }
+            else {
+                stack.pop_back();
+            }
+        }
+        return *this;
+    }
+
+    void ObjectIterator::skip_non_matching() {
+        while (it!=std::default_sentinel) {
+            auto obj = contained_object(*it);
+            if (obj!=nullptr && (mm==nullptr || mm->is_instance(*obj, type))) return;
+            ++it;
+        }
+    }
+
+    void walk(Value& root, const std::function<WalkAction(Object&)>& pre, const std::function<void(Object&)>& post) {
+        struct Frame {
+            Object* obj;
+            size_t slot;
+            size_t index;
+        };
+        std::vector<Frame> stack;
+        auto enter = [&](Value& v) { // false: stop
+            auto obj = contained_object(v);
+            if (obj==nullptr) return true;
+            auto action = pre ? pre(*obj) : WalkAction::descend;
+            if (action==WalkAction::stop) return false;
+            if (action==WalkAction::descend) {
+                stack.push_back({obj, 0, 0});
+            }
+            else if (post) {
+                post(*obj);
+            }
+            return true;
+        };
+        if (!enter(root)) return;
+        while (!stack.empty()) {
+            auto &f = stack.back();
+            if (f.slot<f.obj->attributes.size()) {
+                auto &av = f.obj->attributes.at_slot(f.slot);
+                Value* next = nullptr;
+                if (auto v = std::get_if<Value>(&av.data)) {
+                    f.slot++;
+                    next = v;
+                }
+                else {
+                    auto &list = std::get<std::vector<Value>>(av.data);
+                    if (f.index<list.size()) {
+                        next = &list[f.index++];
+                    }
+                    else {
+                        f.slot++;
+                        f.index = 0;
+                    }
+                }
+                if (next!=nullptr && !enter(*next)) return;
+            }
+            else {
+                auto obj = f.obj;
+                stack.pop_back();
+                if (post) post(*obj);
+            }
+        }
+    }
 }
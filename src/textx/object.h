@@ -6,9 +6,19 @@
 #include <variant>
 #include <utility>
 #include <vector>
+#include <deque>
 #include <memory>
 #include <unordered_map>
 #include <functional>
+#include <cstdint>
+#include <optional>
+#include <algorithm>
+#include <string_view>
+#include <span>
+#include <iterator>
+#include <atomic>
+#include <mutex>
+#include <memory_resource>
 
 namespace textx {
     class Model;
@@ -22,20 +32,164 @@ namespace textx::object {
     class Object;
     struct AttributeValue;
 
-    using MatchedPath = std::vector<std::weak_ptr<Object>>;
+    /**
+     * A weak_ptr which also accepts non-owning shared_ptrs (empty owner), e.g.
+     * for objects allocated in a model arena (see textx::ModelOptions).
+     * Non-owning pointers are stored as raw pointers (their lifetime is bound
+     * to the model) and lock() returns a non-owning shared_ptr again.
+     */
+    template<class T>
+    struct Link {
+        std::weak_ptr<T> weak = {};
+        T* raw = nullptr;
+
+        Link() = default;
+        Link(const std::shared_ptr<T>& p) { *this = p; }
+        Link& operator=(const std::shared_ptr<T>& p) {
+            if (p!=nullptr && p.use_count()==0) {
+                weak.reset();
+                raw = p.get();
+            }
+            else {
+                weak = p;
+                raw = nullptr;
+            }
+            return *this;
+        }
+        std::shared_ptr<T> lock() const {
+            if (raw!=nullptr) return std::shared_ptr<T>(std::shared_ptr<T>{}, raw);
+            return weak.lock();
+        }
+        void reset() { weak.reset(); raw=nullptr; }
+    };
+
+    using MatchedPath = std::vector<Link<Object>>;
+    using TypeId = std::uint32_t; /// dense rule id of a metamodel (see Metamodel::type_id)
+
+    /** state of a reference of a model loaded with ModelOptions::lazy_references (copyable atomic) */
+    struct LazyResolution {
+        enum State : std::uint8_t { none, pending, in_progress };
+        std::atomic<std::uint8_t> state = none;
+
+        LazyResolution() = default;
+        LazyResolution(const LazyResolution& other) : state{other.state.load()} {}
+        LazyResolution& operator=(const LazyResolution& other) {
+            state = other.state.load();
+            return *this;
+        }
+    };
+
+    struct ObjectRef;
+
+    /**
+     * References and imports of published models resolved again by
+     * Workspace::refresh before the results are committed: a thread resolving
+     * with it (see current) sees these targets and imports instead of the
+     * published ones, other threads are not affected.
+     */
+    struct StagedResolution {
+        struct Target {
+            Link<Object> obj = {};
+            MatchedPath objpath = {};
+        };
+        std::unordered_map<const ObjectRef*, Target> refs = {};
+        std::unordered_map<const textx::Model*, std::vector<std::weak_ptr<textx::Model>>> imports = {};
+        static constinit thread_local StagedResolution* current; /// set while resolving (see Metamodel::resolve_references)
+    };
 
+    /** resolves a pending lazy reference once (thread-safe: under the lock of the workspace of its model, see ObjectRef::target); staged targets first (see StagedResolution) */
+    std::shared_ptr<Object> resolve_lazily(const ObjectRef& ref);
+
+    /**
+     * A reference of a model (only created by the model, see Model::create_model).
+     * The name is a view into the model text: it must not be used after the model
+     * was destroyed (like MatchText).
+     */
     struct ObjectRef {
-        std::weak_ptr<textx::Model> tx_model;
-        std::string name;
-        std::string rule;
-        std::string target_type;
-        std::string attr;
-        std::weak_ptr<Object> parent = {};
-        std::weak_ptr<Object> obj = {};
-        MatchedPath objpath = {};
+        Link<textx::Model> tx_model;
+        std::string_view name;          /// view into the model text (valid as long as the model lives)
+        Link<Object> parent = {};
+        mutable Link<Object> obj = {};          /// the target (written once by a lazy resolution, see target)
+        mutable MatchedPath objpath = {};
+        TypeId rule_id = 0;             /// type id of the rule of parent (see Metamodel::tx_rule)
+        std::uint32_t attr_id = 0;      /// attribute id of the reference in that rule (its type is the target type)
+        mutable LazyResolution lazy = {};     /// see ModelOptions::lazy_references
+
+        /** the referenced object; pending lazy references are resolved first (nullptr: not resolved) */
+        std::shared_ptr<Object> target() const {
+            if (lazy.state.load(std::memory_order_acquire)!=LazyResolution::none || StagedResolution::current!=nullptr) {
+                return resolve_lazily(*this);
+            }
+            return obj.lock();
+        }
+    private:
+        /** name must be a part of the text of model */
+        ObjectRef(Link<textx::Model> model, std::string_view name, Link<Object> parent) : tx_model{std::move(model)}, name{name}, parent{std::move(parent)} {}
+        friend textx::Model;
+    };
+
+    /** builtin rule types of matched text (other: user defined match rules) */
+    enum class TextType : std::uint8_t { other, ID, BOOL, INT, FLOAT, STRICTFLOAT, NUMBER, STRING };
+    TextType text_type_of_rule(std::string_view rule_name);
+
+    /** value converted from the text of the builtin rules BOOL, INT, FLOAT, STRICTFLOAT and NUMBER (see MatchText) */
+    enum class Scalar : std::uint8_t { none, integer, floating, boolean };
+
+    /** returns a pooled copy of s (valid until the end of the program, only for the bounded rule and type names) */
+    const std::string& intern(std::string_view s);
+
+    /** a part of a text owned elsewhere (the model text, an unescaped string of the model or a copy owned by a MatchText) */
+    struct TextRange {
+        const std::string* source = nullptr;
+        std::uint32_t offset = 0;
+        std::uint32_t length = 0;
+        std::string_view view() const {
+            return (source==nullptr) ? std::string_view{} : std::string_view{source->data()+offset, length};
+        }
+    };
+
+    /**
+     * Matched text and the name of its rule.
+     * The text is a range of the model text, which is owned by the model (a
+     * value must not be used after its model was destroyed). Unescaped strings
+     * are owned by the model, too (see Model::model_strings); values created
+     * outside a model own a copy of their text.
+     * STRING values are stored w/o quotes and with \" \' \\ \n \t \r replaced.
+     * Text of the builtin number and BOOL types is converted once when the
+     * value is created (decimal integers, other numbers as double, see scalar).
+     */
+    struct MatchText {
+        TextRange range = {};
+        union {
+            std::int64_t int_value = 0; /// Scalar::integer (same result as std::stoll(text(), nullptr, 0))
+            double float_value;         /// Scalar::floating (std::stold(text()) rounded to double)
+            bool bool_value;            /// Scalar::boolean (true, True or 1)
+        };
+        std::uint32_t rule_name = 0;    /// index into the pool of rule names (see rule())
+        TextType type = TextType::other;
+        Scalar scalar = Scalar::none;   /// the valid member of the union (none: the text is converted on access)
+        bool owns_text = false;         /// range.source is a copy owned by this value (created outside a model)
+
+        /** owned copy of text (values created outside a model) */
+        MatchText(std::string_view text, std::string_view rule);
+        /** no copy: text must be a part of source (the model text); unescaped strings are added to strings */
+        MatchText(const std::string& source, std::string_view text, std::string_view rule, std::deque<std::string>& strings);
+        MatchText(const MatchText& other);
+        MatchText(MatchText&& other) noexcept;
+        MatchText& operator=(const MatchText& other);
+        MatchText& operator=(MatchText&& other) noexcept;
+        ~MatchText();
+        std::string_view text() const { return range.view(); }
+        std::string_view rule() const;
+        bool is_number() const {
+            return type==TextType::INT || type==TextType::FLOAT || type==TextType::STRICTFLOAT || type==TextType::NUMBER;
+        }
+    private:
+        void init(const std::string& source, std::string_view text, std::deque<std::string>& strings);
+        void convert_scalar();
+        void copy_scalar(const MatchText& other);
     };
 
-    using MatchText = std::pair<std::string, std::string>; /// first: text, second: rule-type
     struct Value {
         std::variant<MatchText, std::shared_ptr<Object>, ObjectRef, bool> data;
         textx::arpeggio::TextPosition pos;
@@ -74,11 +228,14 @@ namespace textx::object {
             return std::holds_alternative<MatchText>(data);
         }
         bool is_number() const {
-            return std::holds_alternative<MatchText>(data) && 
-            (std::get<MatchText>(data).second=="NUMBER" || std::get<MatchText>(data).second=="INT" || std::get<MatchText>(data).second=="FLOAT" || std::get<MatchText>(data).second=="STRICTFLOAT");
+            return std::holds_alternative<MatchText>(data) && std::get<MatchText>(data).is_number();
         }
 
+        /** boolean assignments (see is_boolean) and text matched by BOOL */
         bool boolean() const {
+            if (auto text = std::get_if<MatchText>(&data); text!=nullptr && text->scalar==Scalar::boolean) {
+                return text->bool_value;
+            }
             TEXTX_ASSERT(std::holds_alternative<bool>(data), "no boolean");
             return std::get<bool>(data);
         }
@@ -99,8 +256,8 @@ namespace textx::object {
             }
             else {
                 TEXTX_ASSERT(std::holds_alternative<ObjectRef>(data));
-                auto res = std::get<ObjectRef>(data).obj.lock();
-                TEXTX_ASSERT(res!=nullptr, "unexpected: reference expired/illegal");
+                auto res = std::get<ObjectRef>(data).target();
+                TEXTX_ASSERT(res!=nullptr, "unexpected: reference unresolved/expired/illegal");
                 return res;
             }
         }
@@ -111,35 +268,44 @@ namespace textx::object {
             }
             else {
                 TEXTX_ASSERT(std::holds_alternative<ObjectRef>(data));
-                return std::get<ObjectRef>(data).obj.lock();
+                return std::get<ObjectRef>(data).target();
             }
         }
 
-        std::string str() const {
+        /** the text without copy (valid as long as the model lives, see MatchText) */
+        std::string_view str_view() const {
             TEXTX_ASSERT(std::holds_alternative<MatchText>(data), " at ", this->pos);
-            if (std::get<MatchText>(data).second=="STRING") {
-                // TODO handle \n, \" etc...
-                return std::get<MatchText>(data).first.substr(1,std::get<MatchText>(data).first.size()-2);
-            }
-            else {
-                return std::get<MatchText>(data).first;
-            }
+            return std::get<MatchText>(data).text();
+        }
+
+        std::string str() const {
+            return std::string{str_view()};
         }
 
         long double f() const {
+            TEXTX_ASSERT(std::holds_alternative<MatchText>(data), " at ", this->pos);
+            auto &text = std::get<MatchText>(data);
+            if (text.scalar==Scalar::floating) return text.float_value;
+            if (text.scalar==Scalar::integer) return text.int_value;
             return std::stold(str());
         }
 
         long long i() const {
+            TEXTX_ASSERT(std::holds_alternative<MatchText>(data), " at ", this->pos);
+            auto &text = std::get<MatchText>(data);
+            if (text.scalar==Scalar::integer) return text.int_value;
             return std::stoll(str(), nullptr, 0);
         }
 
         unsigned long long u() const {
+            TEXTX_ASSERT(std::holds_alternative<MatchText>(data), " at ", this->pos);
+            auto &text = std::get<MatchText>(data);
+            if (text.scalar==Scalar::integer && text.int_value>=0) return static_cast<unsigned long long>(text.int_value);
             return std::stoull(str(), nullptr, 0);
         }
 
-        const AttributeValue& operator[](std::string name) const;
-        AttributeValue& operator[](std::string name);
+        const AttributeValue& operator[](std::string_view name) const;
+        AttributeValue& operator[](std::string_view name);
 
         void print(std::ostream& o, size_t indent=0, bool one_line=false) const;
         friend std::ostream& operator<<(std::ostream& o, const Value&v) {
@@ -241,7 +407,7 @@ namespace textx::object {
             }
             else {
                 TEXTX_ASSERT(std::holds_alternative<ObjectRef>(value.data));
-                return std::get<ObjectRef>(value.data).obj.lock();
+                return std::get<ObjectRef>(value.data).target();
             }
         }
 
@@ -253,10 +419,15 @@ namespace textx::object {
             }
             else {
                 TEXTX_ASSERT(std::holds_alternative<ObjectRef>(value.data));
-                return std::get<ObjectRef>(value.data).obj.lock();
+                return std::get<ObjectRef>(value.data).target();
             }
         }
 
+        std::string_view str_view() const {
+            TEXTX_ASSERT(std::holds_alternative<Value>(data));
+            return std::get<Value>(data).str_view();
+        }
+
         std::string str() const {
             TEXTX_ASSERT(std::holds_alternative<Value>(data));
             auto &value = std::get<Value>(data);
@@ -264,79 +435,400 @@ namespace textx::object {
         }
 
         long double f() const {
-            return std::stold(str());
+            TEXTX_ASSERT(std::holds_alternative<Value>(data));
+            return std::get<Value>(data).f();
         }
 
         long long i() const {
-            return std::stoll(str(), nullptr, 0);
+            TEXTX_ASSERT(std::holds_alternative<Value>(data));
+            return std::get<Value>(data).i();
         }
 
         unsigned long long u() const {
-            return std::stoull(str(), nullptr, 0);
+            TEXTX_ASSERT(std::holds_alternative<Value>(data));
+            return std::get<Value>(data).u();
         }
 
         std::vector<Value>::iterator begin();
         std::vector<Value>::iterator end();
         std::vector<Value>::const_iterator begin() const;
         std::vector<Value>::const_iterator end() const;
-        const AttributeValue& operator[](std::string name) const;
-        AttributeValue& operator[](std::string name);
+        const AttributeValue& operator[](std::string_view name) const;
+        AttributeValue& operator[](std::string_view name);
         const Value& operator[](size_t idx) const;
         Value& operator[](size_t idx);
         size_t size() const;
     };
 
+    /**
+     * The attribute names of objects: one layout per rule (see Rule::tx_attribute_layout)
+     * and shared extensions of it for attributes added later (see Attributes::insert).
+     */
+    struct AttributeLayout {
+        std::vector<std::string> names = {};
+        std::vector<size_t> slots_by_name = {}; /// slots sorted by name (for slot(name))
+        std::shared_ptr<const AttributeLayout> base = nullptr; /// the layout extended by the last name (see extended)
+
+        AttributeLayout() = default;
+        explicit AttributeLayout(std::vector<std::string> attribute_names) : names{std::move(attribute_names)} {
+            slots_by_name.resize(names.size());
+            for (size_t i=0;i<names.size();i++) slots_by_name[i]=i;
+            std::sort(slots_by_name.begin(), slots_by_name.end(), [this](size_t a, size_t b) { return names[a]<names[b]; });
+        }
+        std::optional<size_t> slot(std::string_view name) const {
+            auto p = std::lower_bound(slots_by_name.begin(), slots_by_name.end(), name, [this](size_t a, std::string_view n) { return names[a]<n; });
+            if (p==slots_by_name.end() || names[*p]!=name) return std::nullopt;
+            return *p;
+        }
+        /** this is other or an extension of it (the slots of other are valid here) */
+        bool extends(const AttributeLayout* other) const {
+            for (auto p=this; p!=nullptr; p=p->base.get()) {
+                if (p==other) return true;
+            }
+            return false;
+        }
+        /** layout with name appended; all objects extending a layout by the same name share the result */
+        static std::shared_ptr<const AttributeLayout> extended(const std::shared_ptr<const AttributeLayout>& layout, std::string_view name);
+        static const std::shared_ptr<const AttributeLayout>& empty() {
+            static const std::shared_ptr<const AttributeLayout> e = std::make_shared<const AttributeLayout>();
+            return e;
+        }
+    private:
+        mutable std::mutex extensions_mutex;
+        mutable std::unordered_map<std::string, std::weak_ptr<const AttributeLayout>> extensions = {};
+    };
+
+    /** precomputed attribute access, e.g. obj[key] with key=rule.tx_attr_key("name") */
+    struct AttrKey {
+        const AttributeLayout* layout = nullptr;
+        size_t slot = 0;
+        const std::string& name() const { return layout->names[slot]; }
+    };
+
+    /**
+     * The attribute values of an object (one slot per name of the layout).
+     * Iterating yields (name, value) pairs like a map.
+     */
+    class Attributes {
+        std::shared_ptr<const AttributeLayout> m_layout = AttributeLayout::empty();
+        std::pmr::vector<AttributeValue> values = {};
+
+        template<class A, class V>
+        class basic_iterator {
+            A* attributes = nullptr;
+            size_t idx = 0;
+            std::optional<std::pair<const std::string&, V&>> current = std::nullopt;
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::pair<const std::string&, V&>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = value_type*;
+            using reference = value_type&;
+
+            basic_iterator() = default;
+            basic_iterator(A* attributes, size_t idx) : attributes{attributes}, idx{idx} {}
+            basic_iterator(const basic_iterator& other) : attributes{other.attributes}, idx{other.idx} {}
+            basic_iterator& operator=(const basic_iterator& other) {
+                attributes = other.attributes;
+                idx = other.idx;
+                current.reset();
+                return *this;
+            }
+            reference operator*() {
+                current.emplace(attributes->m_layout->names[idx], attributes->values[idx]);
+                return *current;
+            }
+            pointer operator->() { return &operator*(); }
+            basic_iterator& operator++() { ++idx; return *this; }
+            basic_iterator operator++(int) { auto ret = *this; ++idx; return ret; }
+            bool operator==(const basic_iterator& other) const { return idx==other.idx; }
+            bool operator!=(const basic_iterator& other) const { return idx!=other.idx; }
+            size_t slot() const { return idx; }
+        };
+    public:
+        using iterator = basic_iterator<Attributes, AttributeValue>;
+        using const_iterator = basic_iterator<const Attributes, const AttributeValue>;
+
+        Attributes() = default;
+        /** the slots are allocated from resource (e.g. a model arena, see textx::ModelOptions) */
+        explicit Attributes(std::pmr::memory_resource* resource) : values{resource} {}
+
+        /** set the layout; all values are reset */
+        void reset(std::shared_ptr<const AttributeLayout> layout) {
+            m_layout = std::move(layout);
+            values.assign(m_layout->names.size(), AttributeValue{});
+        }
+        /** adds a slot for name if not present (see AttributeLayout::extended) */
+        AttributeValue& insert(std::string_view name);
+
+        const std::shared_ptr<const AttributeLayout>& layout() const { return m_layout; }
+        size_t size() const { return values.size(); }
+        size_t count(std::string_view name) const { return m_layout->slot(name).has_value() ? 1 : 0; }
+        iterator begin() { return {this, 0}; }
+        iterator end() { return {this, values.size()}; }
+        const_iterator begin() const { return {this, 0}; }
+        const_iterator end() const { return {this, values.size()}; }
+        iterator find(std::string_view name) { return {this, m_layout->slot(name).value_or(values.size())}; }
+        const_iterator find(std::string_view name) const { return {this, m_layout->slot(name).value_or(values.size())}; }
+        AttributeValue& at_slot(size_t slot) { return values[slot]; }
+        const AttributeValue& at_slot(size_t slot) const { return values[slot]; }
+    };
+
+    /**
+     * Index of the contained objects with a text attribute "name" of an object
+     * (see Object::child_names). Children with the same name are chained in
+     * attribute order.
+     */
+    class ChildNames {
+        std::vector<std::shared_ptr<Object>> children = {};
+        std::vector<std::uint32_t> next = {}; /// next child with the same name
+        std::unordered_map<std::string_view, std::uint32_t> first = {};
+    public:
+        static constexpr std::uint32_t npos = ~std::uint32_t{0};
+        explicit ChildNames(const Object& obj);
+
+        class iterator {
+            const ChildNames* names = nullptr;
+            std::uint32_t idx = npos;
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::shared_ptr<Object>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const value_type*;
+            using reference = const value_type&;
+            iterator() = default;
+            iterator(const ChildNames* names, std::uint32_t idx) : names{names}, idx{idx} {}
+            reference operator*() const { return names->children[idx]; }
+            pointer operator->() const { return &names->children[idx]; }
+            iterator& operator++() { idx = names->next[idx]; return *this; }
+            iterator operator++(int) { auto ret = *this; ++*this; return ret; }
+            bool operator==(const iterator& other) const { return idx==other.idx; }
+        };
+        struct Range {
+            iterator b, e;
+            iterator begin() const { return b; }
+            iterator end() const { return e; }
+            bool empty() const { return b==e; }
+        };
+        /** the children named name in attribute order */
+        Range named(std::string_view name) const {
+            auto p = first.find(name);
+            return {{this, p==first.end() ? npos : p->second}, {this, npos}};
+        }
+        /** all named children in attribute order */
+        const std::vector<std::shared_ptr<Object>>& all() const { return children; }
+        size_t size() const { return children.size(); }
+        MemoryUsage memory_usage() const {
+            MemoryUsage res;
+            res.add(children);
+            res.add(next);
+            if (first.bucket_count()>1) res.add(first.bucket_count()*sizeof(void*));
+            res.add(first.size()*(sizeof(std::pair<const std::string_view, std::uint32_t>)+sizeof(void*)), first.size());
+            return res;
+        }
+    };
+
     struct Object {
         std::string type;
-        std::weak_ptr<textx::Model> weak_model;
-        std::unordered_map<std::string, AttributeValue> attributes;
-        std::weak_ptr<Object> weak_parent;
+        TypeId type_id = 0;             /// type id of "type" in the type space of the metamodel of the model
+        std::uint32_t type_space = 0;   /// 0: no type id assigned
+        Link<textx::Model> weak_model;
+        Attributes attributes;
+        Link<Object> weak_parent;
         textx::arpeggio::TextPosition pos;
 
-        Object(std::shared_ptr<Object> parent, textx::arpeggio::TextPosition pos) : weak_parent{parent}, pos(pos) {}
+        Object(std::shared_ptr<Object> parent, textx::arpeggio::TextPosition pos, std::pmr::memory_resource* resource=std::pmr::get_default_resource())
+            : attributes{resource}, weak_parent{parent}, pos(pos) {}
+        /** the contained objects are released with an explicit stack (the depth of a model is not limited by the call stack) */
+        ~Object();
 
         textx::arpeggio::TextPosition get_pos() { return pos; }
         std::shared_ptr<Object> parent() { return weak_parent.lock(); }
         std::shared_ptr<const Object> parent() const { return weak_parent.lock(); }
         std::shared_ptr<textx::Model> tx_model() const { return weak_model.lock(); }
-        bool has_attr(std::string n) { return attributes.count(n)>0; }
-        const AttributeValue& operator[](std::string name) const;
-        AttributeValue& operator[](std::string name);
-        void create_attribute_if_not_present(std::string name);
+        bool has_attr(std::string_view n) const { return attributes.count(n)>0; }
+        const AttributeValue& operator[](std::string_view name) const;
+        AttributeValue& operator[](std::string_view name);
+        AttrKey attr_key(std::string_view name) const;
+        const AttributeValue& operator[](AttrKey key) const {
+            if (attributes.layout()->extends(key.layout)) return attributes.at_slot(key.slot);
+            return (*this)[key.name()]; // other layout
+        }
+        AttributeValue& operator[](AttrKey key) {
+            if (attributes.layout()->extends(key.layout)) return attributes.at_slot(key.slot);
+            return (*this)[key.name()]; // other layout
+        }
+        void create_attribute_if_not_present(std::string_view name);
         bool is_instance(std::string base);
 
         void print(std::ostream& o, size_t indent=0, bool one_line=false) const;
-        AttributeValue fqn_attributes(std::string name) const;
+        /** copy of the attribute (or list element) at a path like "a.b[3].c" (see PathQuery) */
+        AttributeValue fqn_attributes(std::string_view name) const;
+
+        /**
+         * index of the named children (built on first use, e.g., by scoping::dot_separated_name_search).
+         * Call reset_child_names after modifying the children (see Model::reset_type_index).
+         */
+        std::shared_ptr<const ChildNames> child_names() const;
+        void reset_child_names() { child_names_index.store(nullptr); }
+        std::shared_ptr<const ChildNames> tx_child_names_if_built() const { return child_names_index.load(); }
+    private:
+        mutable std::atomic<std::shared_ptr<const ChildNames>> child_names_index = nullptr;
     };
 
-    inline void traverse(textx::object::Value& v, std::function<void(textx::object::Value&)> f) {
-        f(v);
-        if (v.is_str()) {
-            // nothing
-        }
-        else if (v.is_ref()) {
-            // nothing
-        }
-        else if (v.is_boolean()) {
-            // nothing
-        }
-        else if (v.is_null()) {
-            // nothing
-        }
-        else if (v.is_pure_obj()) {
-            for (auto &[k,av]: v.obj()->attributes) {
-                if (std::holds_alternative<textx::object::Value>(av.data)) {
-                    traverse(std::get<textx::object::Value>(av.data),f);
-                }
-                else {
-                    for (auto &iv: std::get<std::vector<textx::object::Value>>(av.data)) {
-                        traverse(iv,f);
-                    }
-                }
-            }
-        }
-        else {
-            textx::arpeggio::raise(v.pos, "unexpected situation (traversing the object)");
+    /**
+     * Result of a PathQuery: refers to an attribute or to a list element in the model (no copy).
+     */
+    template<class AV, class V>
+    struct BasicPathResult {
+        AV* attribute = nullptr;  /// set if the path ends with an attribute name
+        V* element = nullptr;     /// set if the path ends with a list index
+
+        bool is_list() const { return attribute!=nullptr && attribute->is_list(); }
+        V& value() const {
+            if (element!=nullptr) return *element;
+            TEXTX_ASSERT(!attribute->is_list(), "path result is a list");
+            return std::get<Value>(attribute->data);
+        }
+        /** the list elements (or the single value) */
+        std::span<V> values() const {
+            if (is_list()) return std::get<std::vector<Value>>(attribute->data);
+            return std::span<V>{&value(), 1};
+        }
+        auto begin() const { return values().begin(); }
+        auto end() const { return values().end(); }
+        size_t size() const { return values().size(); }
+        auto obj() const { return value().obj(); }
+        std::string_view str_view() const { return value().str_view(); }
+        std::string str() const { return value().str(); }
+        bool boolean() const { return value().boolean(); }
+        long double f() const { return value().f(); }
+        long long i() const { return value().i(); }
+        unsigned long long u() const { return value().u(); }
+    };
+
+    /**
+     * An attribute path like "a.b[3].c" compiled once and evaluated against objects
+     * without parsing the path again.
+     */
+    class PathQuery {
+        struct Step {
+            std::string name;
+            std::optional<size_t> index;
+        };
+        std::vector<Step> steps;
+    public:
+        using Result = BasicPathResult<AttributeValue, Value>;
+        using ConstResult = BasicPathResult<const AttributeValue, const Value>;
+
+        explicit PathQuery(std::string_view path);
+        Result operator()(Object& obj) const;
+        ConstResult operator()(const Object& obj) const;
+    };
+
+    /** the object contained in v (nullptr for null, references, strings, ...) */
+    inline Object* contained_object(Value& v) {
+        auto p = std::get_if<std::shared_ptr<Object>>(&v.data);
+        return (p==nullptr) ? nullptr : p->get();
+    }
+
+    /**
+     * Depth-first pre-order iteration over a value and all values contained in
+     * its objects (references are not followed). An explicit stack is used, so
+     * the depth of a model is not limited by the call stack.
+     */
+    class TreeIterator {
+        struct Frame {
+            Object* obj;
+            size_t slot;
+            size_t index;
+        };
+        std::vector<Frame> stack = {};
+        Value* current = nullptr;
+        bool descend = true;
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Value;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value*;
+        using reference = Value&;
+
+        TreeIterator() = default;
+        explicit TreeIterator(Value& root) : current{&root} {}
+        Value& operator*() const { return *current; }
+        Value* operator->() const { return current; }
+        TreeIterator& operator++();
+        void operator++(int) { ++*this; }
+        /** the values of the object of the current value are not visited */
+        void skip_children() { descend = false; }
+        /** number of objects containing the current value */
+        size_t depth() const { return stack.size(); }
+        bool operator==(std::default_sentinel_t) const { return current==nullptr; }
+    };
+
+    /** pre-order iteration over the contained objects, optionally only objects of a type (incl. derived types) */
+    class ObjectIterator {
+        TreeIterator it = {};
+        const textx::Metamodel* mm = nullptr;
+        TypeId type = 0;
+        void skip_non_matching();
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Object;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Object*;
+        using reference = Object&;
+
+        ObjectIterator() = default;
+        ObjectIterator(Value& root, const textx::Metamodel* mm, TypeId type) : it{root}, mm{mm}, type{type} { skip_non_matching(); }
+        Object& operator*() const { return *contained_object(*it); }
+        Object* operator->() const { return contained_object(*it); }
+        /** the value holding the current object */
+        Value& value() const { return *it; }
+        ObjectIterator& operator++() { ++it; skip_non_matching(); return *this; }
+        void operator++(int) { ++*this; }
+        /** the objects contained in the current object are not visited */
+        void skip_children() { it.skip_children(); }
+        size_t depth() const { return it.depth(); }
+        bool operator==(std::default_sentinel_t) const { return it==std::default_sentinel; }
+    };
+
+    struct TreeRange {
+        Value* root;
+        TreeIterator begin() const { return TreeIterator{*root}; }
+        std::default_sentinel_t end() const { return {}; }
+    };
+    struct ObjectRange {
+        Value* root;
+        const textx::Metamodel* mm = nullptr;
+        TypeId type = 0;
+        ObjectIterator begin() const { return ObjectIterator{*root, mm, type}; }
+        std::default_sentinel_t end() const { return {}; }
+    };
+
+    /** all values: for (auto &v: tree(model->val())) ... */
+    inline TreeRange tree(Value& root) { return {&root}; }
+    /** all objects: for (auto &obj: objects(model->val())) ... */
+    inline ObjectRange objects(Value& root) { return {&root}; }
+    /** all objects of a type (id of the type space of mm, see Metamodel::type_id) */
+    inline ObjectRange objects(Value& root, const textx::Metamodel& mm, TypeId type) { return {&root, &mm, type}; }
+
+    enum class WalkAction {
+        descend,    /// visit the contained objects
+        prune,      /// do not visit the contained objects
+        stop        /// end the walk (no further hooks are called)
+    };
+
+    /**
+     * Depth-first walk over the contained objects with pre- and post-order hooks
+     * (post is called for each object pre was called for, unless the walk was stopped).
+     */
+    void walk(Value& root, const std::function<WalkAction(Object&)>& pre, const std::function<void(Object&)>& post=nullptr);
+
+    /** calls f for all values (see tree) */
+    inline void traverse(textx::object::Value& v, const std::function<void(textx::object::Value&)>& f) {
+        for (auto &x: tree(v)) {
+            f(x);
         }
     }
-}
\ No newline at end of file
+}
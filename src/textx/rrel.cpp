@@ -3,7 +3,11 @@
 #include "textx/arpeggio.h"
 #include "textx/lang.h"
 #include "textx/metamodel.h"
+#include <algorithm>
+#include <optional>
+#include <shared_mutex>
 #include <unordered_map>
+#include <unordered_set>
 
 #define MYDBG(x)
 #define MYYIELD(x) {auto _internal_copy_res = x; co_yield _internal_copy_res;}
@@ -260,9 +264,13 @@ namespace textx::rrel {
         auto obj = data.obj;
         auto mm = data.mm;
         obj = obj->parent();
+        std::optional<textx::object::TypeId> type_id = std::nullopt; // looked up on first use
         while(obj!=nullptr) {
             //std::cout << "...Parent(" << obj->type << ")\n";
-            if (mm->is_instance(obj->type, type)) break;
+            if (!type_id.has_value()) {
+                type_id = mm->type_id(type);
+            }
+            if (mm->is_instance(*obj, type_id.value())) break;
             obj = obj->parent();
         }
         if (obj!=nullptr) {
@@ -340,6 +348,7 @@ namespace textx::rrel {
                         for (auto& itarget: target) {
                             if (itarget.is_ref() && !itarget.is_resolved()) {
                                 MYDBG(std::cout << "postponed...\n";)
+                                textx::scoping::report_blocking_reference(itarget.ref());
                                 MYYIELD((textx::scoping::Postponed{}));
                                 co_return;
                             }
@@ -375,6 +384,7 @@ namespace textx::rrel {
                         //std::cout << "is scalar...\n";
                         auto &itarget = target;
                         if (itarget.is_ref() && !itarget.is_resolved()) {
+                            textx::scoping::report_blocking_reference(itarget.ref());
                             MYYIELD((textx::scoping::Postponed{}));
                             co_return;
                         }
@@ -526,59 +536,605 @@ namespace textx::rrel {
         }
     }
 
-    py::RRELResult find_object_with_path(std::shared_ptr<textx::object::Object> obj, std::vector<std::string> lookup, textx::rrel::RRELExpression& rrel_tree, std::string obj_cls)
-    {
-        auto allowed = [
-            visited=std::vector<std::unordered_set<std::pair<const textx::object::Object*, const textx::rrel::RRELBase*>,textx::utils::pair_hash>>(lookup.size()+1) // recursion breaker
-        ](std::shared_ptr<textx::object::Object> obj, std::vector<std::string> lookup_list, const textx::rrel::RRELBase* e) mutable {
-            TEXTX_ASSERT(lookup_list.size()<visited.size())
-            std::pair<textx::object::Object*, const textx::rrel::RRELBase*> elem{obj.get(), e};
-            if (visited[lookup_list.size()].count(elem)>0) {
-                return false;
+    /**
+     * The expression tree flattened into an instruction list (operands are
+     * indices of other instructions). One instruction per node, such that the
+     * recursion breaker can use the instruction index instead of the node.
+     */
+    struct RRELProgram {
+        enum class Op : std::uint8_t { sequence, path, navigation, dots, parent, brackets, zero_or_more };
+        struct Instruction {
+            Op op;
+            std::uint32_t first = 0;            /// operands[first..first+count): paths, path elements or the repeated element
+            std::uint32_t count = 0;
+            size_t n = 0;                       /// dots
+            bool consume_name = true;           /// navigation
+            bool start_locally = false;         /// zero_or_more
+            bool start_at_root = false;         /// zero_or_more
+            std::string_view name = {};         /// navigation: attribute, parent: type
+            std::string_view fixed_name = {};   /// navigation
+        };
+        std::vector<Instruction> code = {};
+        std::vector<std::uint32_t> operands = {};
+        std::uint32_t entry = 0;
+        bool use_multimodel = false;
+
+        std::uint32_t emit(Instruction i, const std::vector<std::uint32_t>& ops) {
+            i.first = static_cast<std::uint32_t>(operands.size());
+            i.count = static_cast<std::uint32_t>(ops.size());
+            operands.insert(operands.end(), ops.begin(), ops.end());
+            code.push_back(i);
+            return static_cast<std::uint32_t>(code.size()-1);
+        }
+        std::uint32_t compile(const RRELBase& node) {
+            std::vector<std::uint32_t> ops;
+            if (auto s = dynamic_cast<const RRELSequence*>(&node)) {
+                for (auto &p: s->paths) ops.push_back(compile(*p));
+                return emit({Op::sequence}, ops);
             }
-            else {
-                visited[lookup_list.size()].insert(elem);
-                return true;
+            if (auto p = dynamic_cast<const RRELPath*>(&node)) {
+                TEXTX_ASSERT(p->path_elements.size()>0, "empty path");
+                for (auto &e: p->path_elements) ops.push_back(compile(*e));
+                return emit({Op::path}, ops);
             }
-        };
-        // important: use ref(...) here to protect (do not duplicate) the state
-        auto generator_results = rrel_tree.get_next_matches({obj->tx_model()->tx_metamodel(), obj, lookup, {}}, std::ref(allowed), "");
-        for (const py::RRELInternalResult res : generator_results) {
-            if(std::holds_alternative<textx::scoping::Postponed>(res)) {
-                MYDBG(std::cout << "FINAL: POSTPONED\n";)
-                return textx::scoping::Postponed{};
-            }
-            else if (std::get<0>(res).lookup_list.size()==0 && std::get<0>(res).obj!=nullptr) {
-                auto obj = std::get<0>(res).obj;
-                auto mm = std::get<0>(res).mm;
-                if (obj_cls=="" || mm->is_instance(obj->type, obj_cls)) {
-                    MYDBG(std::cout << "FINAL: RES, ";)
-                    MYDBG(obj->print(std::cout);)
-                    MYDBG(std::cout <<"\n";)
-                    return py::RRELResultData{obj, std::get<0>(res).matched_path};
+            if (auto b = dynamic_cast<const RRELBrackets*>(&node)) {
+                ops.push_back(compile(*b->seq));
+                return emit({Op::brackets}, ops);
+            }
+            if (auto z = dynamic_cast<const RRELZeroOrMore*>(&node)) {
+                ops.push_back(compile(*z->path_element));
+                Instruction i{Op::zero_or_more};
+                i.start_locally = z->start_locally();
+                i.start_at_root = z->start_at_root();
+                return emit(i, ops);
+            }
+            if (auto nav = dynamic_cast<const RRELNavigation*>(&node)) {
+                Instruction i{Op::navigation};
+                i.consume_name = nav->consume_name;
+                i.name = nav->name;
+                i.fixed_name = nav->fixed_name;
+                return emit(i, ops);
+            }
+            if (auto d = dynamic_cast<const RRELDots*>(&node)) {
+                Instruction i{Op::dots};
+                i.n = d->n;
+                return emit(i, ops);
+            }
+            if (auto p = dynamic_cast<const RRELParent*>(&node)) {
+                Instruction i{Op::parent};
+                i.name = p->type;
+                return emit(i, ops);
+            }
+            throw std::runtime_error("unexpected RREL element");
+        }
+    };
+
+    const RRELProgram& RRELExpression::program() const {
+        std::call_once(program_once, [this]() {
+            auto p = std::make_shared<RRELProgram>();
+            p->entry = p->compile(*seq);
+            p->use_multimodel = use_multimodel;
+            compiled_program = p;
+        });
+        return *compiled_program;
+    }
+}
+
+namespace {
+    using textx::rrel::RRELProgram;
+    using Op = RRELProgram::Op;
+
+    /** current object, number of consumed lookup names and matched path (index+1 into Scratch::path, 0: empty) */
+    struct State {
+        std::shared_ptr<textx::object::Object> obj;
+        std::uint32_t consumed = 0;
+        std::uint32_t path = 0;
+    };
+
+    /** one active generator (a frame of the former coroutine implementation) */
+    struct Frame {
+        enum class Kind : std::uint8_t { sequence, path, navigation, dots, parent, brackets, zero_or_more, zero_or_more_step };
+        Kind kind;
+        std::uint32_t instr;
+        std::int32_t parent;            /// consumer of the results (-1: find_object_with_path)
+        bool forwarded;                 /// results of a nested generator (not of the element/source)
+        bool first;                     /// first element of the expression
+        State state;
+        std::uint32_t pc = 0;
+        size_t i = 0;                   /// path: element; navigation: start object; zero_or_more: doubles id
+        size_t j = 0;                   /// navigation: list entry
+        size_t n = 0;                   /// navigation: number of start objects
+        textx::object::AttributeValue* target = nullptr; /// navigation: attribute of the current start object
+    };
+
+    /** key of the recursion breaker and the zero_or_more doubles detection */
+    struct VisitKey {
+        const textx::object::Object* obj;
+        size_t id;
+        size_t lookup_size;
+        bool operator==(const VisitKey&) const = default;
+    };
+    struct VisitKeyHash {
+        size_t operator()(const VisitKey& k) const {
+            size_t h = std::hash<const void*>{}(k.obj);
+            h ^= k.id + 0x9e3779b97f4a7c15ULL + (h<<6) + (h>>2);
+            h ^= k.lookup_size + 0x9e3779b97f4a7c15ULL + (h<<6) + (h>>2);
+            return h;
+        }
+    };
+
+    struct PathNode {
+        std::shared_ptr<textx::object::Object> obj;
+        std::uint32_t prev;
+    };
+
+    /** reused memory of find_object_with_path (per thread) */
+    struct Scratch {
+        std::vector<Frame> frames;
+        std::vector<PathNode> path;
+        std::unordered_set<VisitKey, VisitKeyHash> visited;
+        std::unordered_set<VisitKey, VisitKeyHash> doubles;
+        bool in_use = false;
+
+        void clear() {
+            frames.clear();
+            path.clear();
+            visited.clear();
+            doubles.clear();
+        }
+    };
+
+    class Evaluator {
+        const RRELProgram& program;
+        std::span<const std::string_view> lookup;
+        std::shared_ptr<textx::Metamodel> mm;
+        std::string_view obj_cls;
+        std::optional<textx::object::TypeId> obj_cls_id = std::nullopt;
+        Scratch& s;
+        std::optional<textx::rrel::py::RRELResult> result = std::nullopt;
+        size_t doubles_ids = 0;
+
+        const RRELProgram::Instruction& instr(std::uint32_t idx) const { return program.code[idx]; }
+        std::uint32_t operand(const RRELProgram::Instruction& i, size_t k) const { return program.operands[i.first+k]; }
+        size_t lookup_size(const State& st) const { return lookup.size()-st.consumed; }
+
+        bool allowed(const State& st, size_t id) {
+            return s.visited.insert(VisitKey{st.obj.get(), id, lookup_size(st)}).second;
+        }
+
+        Frame::Kind kind_of(Op op) {
+            switch (op) {
+                case Op::sequence: return Frame::Kind::sequence;
+                case Op::path: return Frame::Kind::path;
+                case Op::navigation: return Frame::Kind::navigation;
+                case Op::dots: return Frame::Kind::dots;
+                case Op::parent: return Frame::Kind::parent;
+                case Op::brackets: return Frame::Kind::brackets;
+                case Op::zero_or_more: return Frame::Kind::zero_or_more;
+            }
+            throw std::runtime_error("unexpected RREL instruction");
+        }
+
+        void push(Frame::Kind kind, std::uint32_t instr_idx, size_t parent, bool forwarded, State st, bool first, size_t i=0) {
+            s.frames.push_back(Frame{kind, instr_idx, static_cast<std::int32_t>(parent), forwarded, first, std::move(st)});
+            s.frames.back().i = i;
+        }
+        void push_element(std::uint32_t instr_idx, size_t parent, const State& st, bool first) {
+            push(kind_of(instr(instr_idx).op), instr_idx, parent, false, st, first);
+        }
+
+        void postpone(const textx::object::ObjectRef& ref) {
+            // every consumer passes Postponed on and find_object_with_path returns it
+            textx::scoping::report_blocking_reference(ref);
+            result = textx::scoping::Postponed{};
+        }
+
+        void accept(const State& st) {
+            if (st.consumed!=lookup.size() || st.obj==nullptr) return;
+            if (obj_cls.size()>0) {
+                if (!obj_cls_id.has_value()) obj_cls_id = mm->type_id(std::string{obj_cls});
+                if (!mm->is_instance(*st.obj, obj_cls_id.value())) return;
+            }
+            textx::rrel::MatchedPath matched_path;
+            for (auto p=st.path; p>0; p=s.path[p-1].prev) matched_path.push_back(s.path[p-1].obj);
+            std::reverse(matched_path.begin(), matched_path.end());
+            result = textx::rrel::py::RRELResultData{st.obj, std::move(matched_path)};
+        }
+
+        /** a result (st) of a generator is passed to its consumer */
+        void deliver(std::int32_t to, bool forwarded, const State& st) {
+            if (to<0) {
+                accept(st);
+                return;
+            }
+            auto &f = s.frames[to];
+            switch (f.kind) {
+                case Frame::Kind::sequence:
+                case Frame::Kind::brackets:
+                    deliver(f.parent, f.forwarded, st);
+                    return;
+                case Frame::Kind::path:
+                    if (forwarded || f.i+1==instr(f.instr).count) {
+                        deliver(f.parent, f.forwarded, st);
+                    }
+                    else if (st.obj==nullptr) {
+                        s.frames.erase(s.frames.begin()+to, s.frames.end()); // the remaining results of the element are skipped
+                    }
+                    else {
+                        push(Frame::Kind::path, f.instr, to, true, st, false, f.i+1);
+                    }
+                    return;
+                case Frame::Kind::zero_or_more:
+                    if (s.doubles.insert(VisitKey{st.obj.get(), f.i, lookup_size(st)}).second) {
+                        deliver(f.parent, f.forwarded, st);
+                    }
+                    return;
+                case Frame::Kind::zero_or_more_step:
+                    if (forwarded) {
+                        deliver(f.parent, f.forwarded, st);
+                    }
+                    else {
+                        push(Frame::Kind::zero_or_more_step, f.instr, to, true, st, false);
+                    }
+                    return;
+                default:
+                    throw std::runtime_error("unexpected RREL frame");
+            }
+        }
+
+        void yield(size_t idx, const State& st) {
+            deliver(s.frames[idx].parent, s.frames[idx].forwarded, st);
+        }
+
+        void step_navigation(size_t idx) {
+            auto &f = s.frames[idx];
+            auto &nav = instr(f.instr);
+            if (f.pc==0) {
+                if (!allowed(f.state, f.instr) || (lookup_size(f.state)==0 && nav.consume_name)) {
+                    s.frames.pop_back();
+                    return;
+                }
+                if (f.first) { // always start_at_root
+                    f.state.obj = f.state.obj->tx_model()->val().obj();
+                }
+                f.n = 1;
+                if (f.state.obj->parent()==nullptr && program.use_multimodel) {
+                    f.n += f.state.obj->tx_model()->tx_imported_models().size();
+                }
+                f.pc = 1;
+                f.i = 0;
+                f.j = 0;
+                f.target = nullptr;
+            }
+            for (; f.i<f.n; f.i++, f.j=0, f.target=nullptr) {
+                if (f.j==0) {
+                    std::shared_ptr<textx::object::Object> start = f.state.obj;
+                    if (f.i>0) {
+                        auto m = f.state.obj->tx_model()->tx_imported_models()[f.i-1].lock();
+                        if (!m->val().is_obj()) continue;
+                        start = m->val().obj();
+                    }
+                    if (start==nullptr || !start->has_attr(nav.name)) continue;
+                    f.target = &(*start)[nav.name];
+                }
+                auto &target = *f.target;
+                if (target.is_list()) {
+                    auto &values = std::get<std::vector<textx::object::Value>>(target.data);
+                    while (f.j<values.size()) {
+                        auto &itarget = values[f.j++];
+                        if (itarget.is_ref() && !itarget.is_resolved()) {
+                            postpone(itarget.ref());
+                            return;
+                        }
+                        else if (!nav.consume_name) {
+                            auto obj = itarget.obj();
+                            if (nav.fixed_name.size()>0 && obj!=nullptr && obj->has_attr("name")) {
+                                if ((*obj)["name"].str_view() == nav.fixed_name) {
+                                    yield(idx, State{std::move(obj), f.state.consumed, f.state.path});
+                                    return;
+                                }
+                            }
+                            else {
+                                TEXTX_ASSERT(nav.fixed_name.size()==0, "when specifying a fixed name you need to reference an attribute with a name");
+                                yield(idx, State{std::move(obj), f.state.consumed, f.state.path});
+                                return;
+                            }
+                        }
+                        else if (!itarget.is_null()) {
+                            auto obj = itarget.obj();
+                            if (obj->has_attr("name") && (*obj)["name"].str_view() == lookup[f.state.consumed]) {
+                                yield(idx, consume(f.state, std::move(obj)));
+                                return;
+                            }
+                        }
+                    }
+                }
+                else if (f.j==0) { // scalar
+                    f.j = 1;
+                    auto &itarget = target;
+                    if (itarget.is_ref() && !itarget.is_resolved()) {
+                        postpone(itarget.ref());
+                        return;
+                    }
+                    else if (!nav.consume_name) {
+                        yield(idx, State{itarget.obj(), f.state.consumed, f.state.path});
+                        return;
+                    }
+                    else if (!itarget.is_null()) {
+                        auto obj = itarget.obj();
+                        if (obj->has_attr("name") && (*obj)["name"].str_view() == lookup[f.state.consumed]) {
+                            yield(idx, consume(f.state, std::move(obj)));
+                            return;
+                        }
+                    }
                 }
             }
+            s.frames.pop_back();
+        }
+
+        State consume(const State& st, std::shared_ptr<textx::object::Object> obj) {
+            s.path.push_back(PathNode{obj, st.path});
+            return State{std::move(obj), st.consumed+1, static_cast<std::uint32_t>(s.path.size())};
+        }
+
+        /** resumes the generator on top of the stack (all its nested generators are exhausted) */
+        void step() {
+            size_t idx = s.frames.size()-1;
+            auto &f = s.frames[idx];
+            auto &i = instr(f.instr);
+            switch (f.kind) {
+                case Frame::Kind::sequence:
+                    if (f.pc==0) {
+                        f.pc = 1;
+                        if (!allowed(f.state, f.instr)) f.i = i.count;
+                    }
+                    if (f.i<i.count) {
+                        f.i++;
+                        push(Frame::Kind::path, operand(i, f.i-1), idx, false, f.state, f.first);
+                    }
+                    else {
+                        s.frames.pop_back();
+                    }
+                    return;
+                case Frame::Kind::brackets:
+                    if (f.pc==0 && allowed(f.state, f.instr)) {
+                        f.pc = 1;
+                        push(Frame::Kind::sequence, operand(i, 0), idx, false, f.state, f.first);
+                    }
+                    else {
+                        s.frames.pop_back();
+                    }
+                    return;
+                case Frame::Kind::path:
+                    if (f.pc==0) {
+                        f.pc = 1;
+                        push_element(operand(i, f.i), idx, f.state, f.first);
+                    }
+                    else {
+                        s.frames.pop_back();
+                    }
+                    return;
+                case Frame::Kind::navigation:
+                    step_navigation(idx);
+                    return;
+                case Frame::Kind::dots:
+                    if (f.pc==0) {
+                        f.pc = 1;
+                        size_t counter = i.n;
+                        auto obj = f.state.obj;
+                        while (counter>1 && obj->parent()!=nullptr) {
+                            obj = obj->parent();
+                            counter--;
+                        }
+                        if (counter==1) {
+                            yield(idx, State{std::move(obj), f.state.consumed, f.state.path});
+                            return;
+                        }
+                    }
+                    s.frames.pop_back();
+                    return;
+                case Frame::Kind::parent:
+                    if (f.pc==0) {
+                        f.pc = 1;
+                        auto obj = f.state.obj->parent();
+                        std::optional<textx::object::TypeId> type_id = std::nullopt; // looked up on first use
+                        while (obj!=nullptr) {
+                            if (!type_id.has_value()) type_id = mm->type_id(std::string{i.name});
+                            if (mm->is_instance(*obj, type_id.value())) break;
+                            obj = obj->parent();
+                        }
+                        if (obj!=nullptr) {
+                            yield(idx, State{std::move(obj), f.state.consumed, f.state.path});
+                            return;
+                        }
+                    }
+                    s.frames.pop_back();
+                    return;
+                case Frame::Kind::zero_or_more:
+                    if (f.pc==0) {
+                        f.pc = 1;
+                        f.i = doubles_ids++;
+                        push(Frame::Kind::zero_or_more_step, f.instr, idx, false, f.state, f.first);
+                    }
+                    else {
+                        s.frames.pop_back();
+                    }
+                    return;
+                case Frame::Kind::zero_or_more_step:
+                    // yields the start object(s) and then the results of the element, each
+                    // followed by the results of a nested step (see deliver)
+                    switch (f.pc) {
+                        case 0:
+                            TEXTX_ASSERT(i.start_locally || i.start_at_root);
+                            if (!allowed(f.state, f.instr)) {
+                                s.frames.pop_back();
+                                return;
+                            }
+                            if (!f.first) {
+                                f.pc = 3;
+                                yield(idx, f.state);
+                                return;
+                            }
+                            f.pc = 1;
+                            [[fallthrough]];
+                        case 1:
+                            f.pc = 2;
+                            if (i.start_locally) {
+                                yield(idx, f.state);
+                                return;
+                            }
+                            [[fallthrough]];
+                        case 2:
+                            f.pc = 3;
+                            if (i.start_at_root) {
+                                auto model = f.state.obj->tx_model();
+                                if (model->val().is_obj()) {
+                                    yield(idx, State{model->val().obj(), f.state.consumed, f.state.path});
+                                    return;
+                                }
+                            }
+                            [[fallthrough]];
+                        case 3:
+                            f.pc = 4;
+                            push_element(operand(i, 0), idx, f.state, f.first);
+                            return;
+                        default:
+                            s.frames.pop_back();
+                            return;
+                    }
+            }
+        }
+
+    public:
+        Evaluator(const RRELProgram& program, std::shared_ptr<textx::Metamodel> mm, std::string_view obj_cls, Scratch& s)
+        : program{program}, mm{std::move(mm)}, obj_cls{obj_cls}, s{s} {}
+
+        /** may be called more than once (e.g., find_objects_with_path) */
+        textx::rrel::py::RRELResult run(std::shared_ptr<textx::object::Object> obj, std::span<const std::string_view> lookup_names) {
+            s.clear();
+            lookup = lookup_names;
+            result = std::nullopt;
+            doubles_ids = 0;
+            push(Frame::Kind::sequence, program.entry, 0, false, State{std::move(obj)}, true);
+            s.frames.back().parent = -1;
+            while (!result.has_value() && !s.frames.empty()) {
+                step();
+            }
+            if (result.has_value()) return std::move(result.value());
+            return textx::rrel::py::RRELResultData{nullptr,{}};
+        }
+    };
+
+    /** the scratch memory of this thread (or a new one for nested calls, e.g., from a metamodel callback) */
+    class ScratchLease {
+        std::optional<Scratch> own_scratch = std::nullopt;
+        Scratch& s;
+        static Scratch& thread_scratch() {
+            thread_local Scratch scratch;
+            return scratch;
+        }
+    public:
+        ScratchLease() : s{thread_scratch().in_use ? own_scratch.emplace() : thread_scratch()} {
+            s.in_use = true;
+        }
+        ~ScratchLease() {
+            s.clear();
+            s.in_use = false;
+        }
+        ScratchLease(const ScratchLease&) = delete;
+        ScratchLease& operator=(const ScratchLease&) = delete;
+        Scratch& get() { return s; }
+    };
+
+    struct ExpressionCache {
+        std::shared_mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<const textx::rrel::RRELExpression>, textx::utils::string_hash, std::equal_to<>> expressions;
+    };
+    ExpressionCache& expression_cache() {
+        static ExpressionCache cache;
+        return cache;
+    }
+}
+
+namespace textx::rrel {
+    void split_lookup(std::string_view lookup, std::string_view split_string, std::vector<std::string_view>& parts) {
+        size_t start;
+        size_t end = 0;
+        while ((start = lookup.find_first_not_of(split_string, end)) != std::string_view::npos) {
+            end = lookup.find(split_string, start);
+            parts.push_back(lookup.substr(start, end==std::string_view::npos ? end : end - start));
         }
-        return py::RRELResultData{nullptr,{}};
+    }
+
+    py::RRELResult find_object_with_path(std::shared_ptr<textx::object::Object> obj, std::span<const std::string_view> lookup, const RRELExpression& rrel_tree, std::string_view obj_cls)
+    {
+        ScratchLease scratch;
+        Evaluator evaluator{rrel_tree.program(), obj->tx_model()->tx_metamodel(), obj_cls, scratch.get()};
+        return evaluator.run(std::move(obj), lookup);
+    }
+
+    std::vector<py::RRELResult> find_objects_with_path(std::shared_ptr<textx::object::Object> obj, std::span<const std::string> lookups, const RRELExpression& rrel_tree, std::string_view obj_cls, std::string_view split_string)
+    {
+        std::vector<py::RRELResult> res;
+        res.reserve(lookups.size());
+        ScratchLease scratch;
+        Evaluator evaluator{rrel_tree.program(), obj->tx_model()->tx_metamodel(), obj_cls, scratch.get()};
+        std::vector<std::string_view> parts;
+        for (auto &lookup: lookups) {
+            parts.clear();
+            split_lookup(lookup, split_string, parts);
+            res.push_back(evaluator.run(obj, parts));
+        }
+        return res;
+    }
+
+    std::shared_ptr<const RRELExpression> get_RREL_expression(std::string_view rrel_expression_string) {
+        auto &cache = expression_cache();
+        {
+            std::shared_lock lock{cache.mutex};
+            auto p = cache.expressions.find(rrel_expression_string);
+            if (p!=cache.expressions.end()) return p->second;
+        }
+        std::shared_ptr<const RRELExpression> expression = create_RREL_expression(std::string{rrel_expression_string});
+        std::unique_lock lock{cache.mutex};
+        return cache.expressions.try_emplace(std::string{rrel_expression_string}, expression).first->second;
+    }
+
+    py::RRELResult find_object_with_path(std::shared_ptr<textx::object::Object> obj, std::vector<std::string> lookup, const textx::rrel::RRELExpression& rrel_tree, std::string obj_cls)
+    {
+        std::vector<std::string_view> parts{lookup.begin(), lookup.end()};
+        return find_object_with_path(std::move(obj), std::span<const std::string_view>{parts}, rrel_tree, obj_cls);
     }
 
     std::tuple<std::shared_ptr<textx::object::Object>, MatchedPath> RRELScopeProvider::resolve(std::shared_ptr<textx::object::Object> origin, std::string obj_name, std::optional<std::string> target_type) const
     {
-        std::string type="";
-        if (target_type.has_value()) {
-            type = *target_type;
+        auto model = origin->tx_model();
+        auto cache = model->tx_scope_cache();
+        const textx::object::Object* scope = nullptr;
+        auto type = textx::scoping::ScopeCache::no_type;
+        if (cache!=nullptr) {
+            scope = starts_locally ? origin.get() : model->val().obj().get();
+            if (target_type.has_value()) type = model->tx_metamodel()->type_id(*target_type);
+            if (auto cached = cache->find(this, scope, obj_name, type)) {
+                return *cached;
+            }
         }
+
+        std::vector<std::string_view> parts;
+        split_lookup(obj_name, split_string, parts);
         auto res = textx::rrel::find_object_with_path(
             origin,
-            obj_name,
+            std::span<const std::string_view>{parts},
             *rrel_expression,
-            type,
-            split_string);
+            target_type.has_value() ? std::string_view{*target_type} : std::string_view{});
         if (std::holds_alternative<textx::scoping::Postponed>(res)) {
             return {nullptr, {}};
         }
         else {
             auto [obj, objpath] = std::get<0>(res);
+            if (cache!=nullptr) {
+                cache->insert(this, scope, obj_name, type, {obj, objpath});
+            }
             return {obj, objpath};
         }
     }
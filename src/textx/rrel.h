@@ -10,7 +10,10 @@
 #include <cppcoro/generator.hpp>
 #endif
 #include <string>
+#include <string_view>
+#include <span>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <iostream>
 #include <sstream>
@@ -71,6 +74,7 @@ namespace textx::rrel {
     };
 
     struct RRELSequence;
+    struct RRELProgram;
 
     struct RRELExpression : RRELBase {
         std::unique_ptr<RRELSequence> seq;
@@ -86,6 +90,11 @@ namespace textx::rrel {
             AllowedFunc allowed,
             bool first_element=false
         ) const override;
+        /** the flattened expression used by find_object_with_path (compiled on first use) */
+        const RRELProgram& program() const;
+    private:
+        mutable std::once_flag program_once;
+        mutable std::shared_ptr<const RRELProgram> compiled_program;
     };
 
     struct RRELParent : RRELPathElement {
@@ -217,30 +226,41 @@ namespace textx::rrel {
 
     std::unique_ptr<RRELExpression> create_RREL_expression(const textx::arpeggio::Match& m);
     std::unique_ptr<RRELExpression> create_RREL_expression(std::string rrel_expression_string);
+    /** the compiled expression from a process wide cache (thread-safe; created with create_RREL_expression on first use) */
+    std::shared_ptr<const RRELExpression> get_RREL_expression(std::string_view rrel_expression_string);
+
+    /**
+     * Evaluates the compiled expression (see RRELExpression::program) with an
+     * explicit frame stack; same results and search order as get_next_matches.
+     * Scratch memory is reused per thread.
+     */
+    py::RRELResult find_object_with_path(std::shared_ptr<textx::object::Object> obj, std::span<const std::string_view> lookup, const textx::rrel::RRELExpression& rrel_tree, std::string_view obj_cls="");
+    py::RRELResult find_object_with_path(std::shared_ptr<textx::object::Object> obj, std::vector<std::string> lookup, const textx::rrel::RRELExpression& rrel_tree, std::string obj_cls="");
+    /**
+     * find_object_with_path for many lookups (separated by split_string) with
+     * the same origin and expression: the setup and the scratch memory of the
+     * evaluation are shared.
+     */
+    std::vector<py::RRELResult> find_objects_with_path(std::shared_ptr<textx::object::Object> obj, std::span<const std::string> lookups, const textx::rrel::RRELExpression& rrel_tree, std::string_view obj_cls="", std::string_view split_string=".");
+
+    /** the parts of lookup separated by split_string (w/o empty parts) */
+    void split_lookup(std::string_view lookup, std::string_view split_string, std::vector<std::string_view>& parts);
 
-    py::RRELResult find_object_with_path(std::shared_ptr<textx::object::Object> obj, std::vector<std::string> lookup, textx::rrel::RRELExpression& rrel_tree, std::string obj_cls="");
     inline py::RRELResult find_object_with_path(
         std::shared_ptr<textx::object::Object> obj,
         std::variant<std::string,std::vector<std::string>> lookup,
-        textx::rrel::RRELExpression& rrel_tree, 
+        const textx::rrel::RRELExpression& rrel_tree, 
         std::string obj_cls="", 
         std::string split_string=".")
     {
-        std::vector<std::string> new_lookup {};
         if (std::holds_alternative<std::string>(lookup)) {
-            std::string& str = std::get<std::string>(lookup);
-            size_t start;
-            size_t end = 0;
-        	while ((start = str.find_first_not_of(split_string, end)) != std::string::npos)
-            {
-                end = str.find(split_string, start);
-                new_lookup.push_back(str.substr(start, end - start));
-            }
+            std::vector<std::string_view> parts;
+            split_lookup(std::get<std::string>(lookup), split_string, parts);
+            return find_object_with_path(obj, std::span<const std::string_view>{parts}, rrel_tree, obj_cls);
         }
         else {
-            new_lookup = std::move(std::get<std::vector<std::string>>(lookup));
+            return find_object_with_path(obj, std::move(std::get<std::vector<std::string>>(lookup)), rrel_tree, obj_cls);
         }
-        return find_object_with_path(obj, new_lookup, rrel_tree, obj_cls);
     }
     inline py::RRELResult find_object_with_path(
         std::shared_ptr<textx::object::Object> obj,
@@ -249,7 +269,7 @@ namespace textx::rrel {
         std::string obj_cls="", 
         std::string split_string=".") 
     {
-        auto rrel = create_RREL_expression(rrel_tree);
+        auto rrel = get_RREL_expression(rrel_tree);
         return find_object_with_path(obj, lookup, *rrel, obj_cls, split_string);
     }
 
@@ -270,6 +290,22 @@ namespace textx::rrel {
         }
     }
 
+    /** find for many lookups (see find_objects_with_path); nullptr for postponed elements */
+    inline std::vector<std::shared_ptr<textx::object::Object>> find_all(
+        std::shared_ptr<textx::object::Object> obj,
+        std::span<const std::string> lookups,
+        std::string_view rrel_tree,
+        std::string_view obj_cls="",
+        std::string_view split_string=".")
+    {
+        std::vector<std::shared_ptr<textx::object::Object>> objs;
+        objs.reserve(lookups.size());
+        for (auto &res: find_objects_with_path(obj, lookups, *get_RREL_expression(rrel_tree), obj_cls, split_string)) {
+            objs.push_back(std::holds_alternative<textx::scoping::Postponed>(res) ? nullptr : std::get<0>(res).obj);
+        }
+        return objs;
+    }
+
     inline std::string build_fqn(const MatchedPath& objpath, std::string separator=".") {
         std::string n="";
         for (size_t i=0;i<objpath.size();i++) {
@@ -284,9 +320,10 @@ namespace textx::rrel {
     class RRELScopeProvider : public textx::scoping::RefResolver {
         std::unique_ptr<RRELExpression> rrel_expression;
         std::string split_string;
+        bool starts_locally; // the result depends on the origin (else only on its model, see textx/scope_cache.h)
     public:
-        RRELScopeProvider(const textx::arpeggio::Match& m,std::string split_string=".") : rrel_expression{create_RREL_expression(m)}, split_string{split_string} {}
-        RRELScopeProvider(std::string rrel_string,std::string split_string=".") : rrel_expression{create_RREL_expression(rrel_string)}, split_string{split_string} {}
+        RRELScopeProvider(const textx::arpeggio::Match& m,std::string split_string=".") : rrel_expression{create_RREL_expression(m)}, split_string{split_string}, starts_locally{rrel_expression->seq->start_locally()} {}
+        RRELScopeProvider(std::string rrel_string,std::string split_string=".") : rrel_expression{create_RREL_expression(rrel_string)}, split_string{split_string}, starts_locally{rrel_expression->seq->start_locally()} {}
         std::tuple<std::shared_ptr<textx::object::Object>, MatchedPath> resolve(std::shared_ptr<textx::object::Object> origin, std::string obj_name, std::optional<std::string> target_type) const override;
     };
 }
@@ -12,6 +12,7 @@ namespace {
     using RULE = textx::Rule;
     using METAMODEL = textx::Metamodel;
     namespace ta = textx::arpeggio;
+    namespace te = textx::expression;
 
     template<class... Ts> struct overloaded : Ts... { using Ts::operator()...; };
     template<class... Ts> overloaded(Ts...) -> overloaded<Ts...>;
@@ -20,14 +21,14 @@ namespace {
         bool in_assignment=false;
     };
 
-    ta::Pattern transform_match2pattern(ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match);
+    te::Expression transform_match2expression(ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match);
 
     struct Eolterm{};
     struct None{};
-    using Repeat_modifiers = std::variant<ta::Pattern, Eolterm, None>;
+    using Repeat_modifiers = std::variant<te::Expression, Eolterm, None>;
     Repeat_modifiers get_repeat_modifiers(ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& m);
 
-    /** get the repat modifiers info from a Match from ta::optional(ref("repeat_modifiers")) */
+    /** get the repat modifiers info from a Match from te::optional(ref("repeat_modifiers")) */
     Repeat_modifiers extract_repeat_modifiers(ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& repeat_modifiers_match) {
         Repeat_modifiers repeat_modifiers = None{};
         if (repeat_modifiers_match.children.size()>0) {
@@ -40,55 +41,55 @@ namespace {
     }
 
     /** preprocess an expression with a special case for unordered_groups */
-    ta::Pattern normal_expression_or_unordered_choice(ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match, bool use_choice, const Repeat_modifiers &repeat_modifiers) {
+    te::Expression normal_expression_or_unordered_choice(ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match, bool use_choice, const Repeat_modifiers &repeat_modifiers) {
         auto &expr = match;
         TEXTX_ASSERT(expr.name_starts_with("rule://expression"));
         if(expr.children[0].name.has_value() && expr.children[0].name.value() == "rule://assignment") {
-            return transform_match2pattern(parsestate, mm, rule, expr.children[0]);
+            return transform_match2expression(parsestate, mm, rule, expr.children[0]);
         }
         else {
             TEXTX_ASSERT_EQUAL(expr.children[0].children[1].type(), ta::MatchType::ordered_choice);
-            ta::Pattern part_of_expression;
+            te::Expression part_of_expression;
             if (use_choice) {
                 auto choice = expr.children[0].children[1].children[0];
                 TEXTX_ASSERT_EQUAL(choice.name.value(),"rule://bracketed_choice"); // must be "(" ... ")" for "#"
                 TEXTX_ASSERT_EQUAL(choice.children[1].type(), ta::MatchType::sequence);
                 TEXTX_ASSERT_EQUAL(choice.children[1].children.size(),2);
 
-                std::vector<ta::Pattern> patterns={};
+                std::vector<te::Expression> patterns={};
                 if(choice.children[1].children[1].children.size()>0) {
                     // we have a choice here (e.g., "a|b|c")
                     auto &seq = choice.children[1].children[0]; // "(" .#1. ")"
-                    patterns.push_back(transform_match2pattern(parsestate, mm, rule, seq));
+                    patterns.push_back(transform_match2expression(parsestate, mm, rule, seq));
                     for(auto &c : choice.children[1].children[1].children) {
-                        patterns.push_back(transform_match2pattern( parsestate, mm, rule, c.children[1])); // see lang.cpp, use sequence after '|'
+                        patterns.push_back(transform_match2expression( parsestate, mm, rule, c.children[1])); // see lang.cpp, use sequence after '|'
                     }
                 }
                 else {
                     auto &seq = choice.children[1].children[0]; // "(" .#1. ")"
                     for(auto &c : seq.children) {
-                        patterns.push_back(transform_match2pattern( parsestate, mm, rule, c));
+                        patterns.push_back(transform_match2expression( parsestate, mm, rule, c));
                     }
                 }
-                if (std::holds_alternative<ta::Pattern>(repeat_modifiers)) {
-                    part_of_expression = ta::unordered_group(patterns, std::get<ta::Pattern>(repeat_modifiers));
+                if (std::holds_alternative<te::Expression>(repeat_modifiers)) {
+                    part_of_expression = te::unordered_group(patterns, std::get<te::Expression>(repeat_modifiers));
                 }
                 else {
-                    part_of_expression = ta::unordered_group(patterns, std::nullopt);
+                    part_of_expression = te::unordered_group(patterns, std::nullopt);
                 }
             }
             else {
-                part_of_expression = transform_match2pattern(parsestate, mm, rule, expr.children[0].children[1].children[0]);
+                part_of_expression = transform_match2expression(parsestate, mm, rule, expr.children[0].children[1].children[0]);
             }
             if (expr.children[0].children[0].children.size()>0) {
                 TEXTX_ASSERT_EQUAL(expr.children[0].children[0].children.size(), 1);
                 std::string syntactic_predicate = expr.children[0].children[0].children[0].captured.value(); // "!" or "&"
                 if (syntactic_predicate=="!") {
-                    return ta::negative_lookahead(part_of_expression);
+                    return te::negative_lookahead(part_of_expression);
                 }
                 else {
                     TEXTX_ASSERT_EQUAL(syntactic_predicate,"&");
-                    return ta::positive_lookahead(part_of_expression);
+                    return te::positive_lookahead(part_of_expression);
                 }
             }
             else {
@@ -139,38 +140,38 @@ namespace {
     }
 
     /** normal node "visitors" */
-    std::unordered_map<std::string, std::function<ta::Pattern(ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match)>> transform_match2pattern_map = {
+    std::unordered_map<std::string, std::function<te::Expression(ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match)>> transform_match2expression_map = {
         {
             "rule://textx_rule_body",
-            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> ta::Pattern {
-                return transform_match2pattern(parsestate, mm, rule, match.children[0]);
+            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> te::Expression {
+                return transform_match2expression(parsestate, mm, rule, match.children[0]);
             }
         },
         {
             "rule://choice",
-            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> ta::Pattern {
+            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> te::Expression {
                 auto seq1 = match.children[0];
                 auto zom_seq2 = match.children[1];
-                std::vector<ta::Pattern> c{ transform_match2pattern(parsestate, mm, rule, seq1) };
+                std::vector<te::Expression> c{ transform_match2expression(parsestate, mm, rule, seq1) };
                 for (auto &inner_seq_with_two_entries: zom_seq2.children) {
-                    c.emplace_back( transform_match2pattern( parsestate, mm, rule, inner_seq_with_two_entries.children[1]) );
+                    c.emplace_back( transform_match2expression( parsestate, mm, rule, inner_seq_with_two_entries.children[1]) );
                 }
-                return ta::ordered_choice(c);
+                return te::ordered_choice(c);
             }
         },
         {
             "rule://sequence",
-            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> ta::Pattern {
-                std::vector<ta::Pattern> c{};
+            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> te::Expression {
+                std::vector<te::Expression> c{};
                 for (auto &inner_entry: match.children) {
-                    c.emplace_back( transform_match2pattern( parsestate, mm, rule, inner_entry));
+                    c.emplace_back( transform_match2expression( parsestate, mm, rule, inner_entry));
                 }
-                return ta::sequence(c);
+                return te::sequence(c);
             }
         },
         {
             "rule://repeatable_expr",
-            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> ta::Pattern {
+            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> te::Expression {
                 // operator *+#?
                 TEXTX_ASSERT(match.children[1].captured.has_value());
                 std::string op = "";
@@ -199,21 +200,21 @@ namespace {
                 }
                 else if (op=="*") {
                     return std::visit(overloaded{
-                        [&](ta::Pattern&p) -> ta::Pattern { return ta::optional(ta::sequence({expression, ta::zero_or_more(ta::sequence({p, expression}))})); },
-                        [&](Eolterm&) -> ta::Pattern { return ta::eolterm(ta::zero_or_more(expression)); },
-                        [&](None&) -> ta::Pattern { return ta::zero_or_more(expression); }
+                        [&](te::Expression&p) -> te::Expression { return te::optional(te::sequence({expression, te::zero_or_more(te::sequence({p, expression}))})); },
+                        [&](Eolterm&) -> te::Expression { return te::eolterm(te::zero_or_more(expression)); },
+                        [&](None&) -> te::Expression { return te::zero_or_more(expression); }
                     }, repeat_modifiers);
                 }
                 else if (op=="+") {
                     return std::visit(overloaded{
-                        [&](ta::Pattern&p) -> ta::Pattern { return ta::sequence({expression, ta::zero_or_more(ta::sequence({p, expression}))}); },
-                        [&](Eolterm&) -> ta::Pattern { return ta::eolterm(ta::one_or_more(expression)); },
-                        [&](None&) -> ta::Pattern { return ta::one_or_more(expression); }
+                        [&](te::Expression&p) -> te::Expression { return te::sequence({expression, te::zero_or_more(te::sequence({p, expression}))}); },
+                        [&](Eolterm&) -> te::Expression { return te::eolterm(te::one_or_more(expression)); },
+                        [&](None&) -> te::Expression { return te::one_or_more(expression); }
                     }, repeat_modifiers);
                 }
                 else if (op=="?") {
                     TEXTX_ASSERT(std::holds_alternative<None>(repeat_modifiers),"no repeat modifiers allowed for an optional assignment");
-                    return ta::optional(expression);
+                    return te::optional(expression);
                 }
                 else if (op=="#") {
                     return expression; // '#' handled in normal_expression_or_unordered_choice
@@ -225,43 +226,43 @@ namespace {
         },
         {
             "rule://expression",
-            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> ta::Pattern {
-                return transform_match2pattern( parsestate, mm, rule, match.children[0]);
+            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> te::Expression {
+                return transform_match2expression( parsestate, mm, rule, match.children[0]);
             }
         },
         {
             "rule://simple_match",
-            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> ta::Pattern {
-                return transform_match2pattern( parsestate, mm, rule, match.children[0]);
+            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> te::Expression {
+                return transform_match2expression( parsestate, mm, rule, match.children[0]);
             }
         },
         {
             "rule://str_match",
-            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> ta::Pattern {
+            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> te::Expression {
                 std::string str = match.captured.value();
                 TEXTX_ASSERT(str.size()>=2);
                 str = str.substr(1,str.size()-2);
-                return ta::str_match(str);
+                return te::str_match(str);
             }
         },
         {
             "rule://re_match",
-            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> ta::Pattern {
+            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> te::Expression {
                 std::string str = match.captured.value();
                 TEXTX_ASSERT(str.size()>=2);
                 str = str.substr(1,str.size()-2);
-                return ta::capture(ta::regex_match(str));
+                return te::regex_match(str, true);
             }
         },
         {
             "rule://bracketed_choice",
-            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> ta::Pattern {
-                return transform_match2pattern( parsestate, mm, rule, match.children[1]);
+            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> te::Expression {
+                return transform_match2expression( parsestate, mm, rule, match.children[1]);
             }
         },
         {
             "rule://assignment",
-            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> ta::Pattern {
+            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> te::Expression {
                 parsestate.in_assignment = true;
                 TEXTX_ASSERT_EQUAL(match.children.size(),3 , "assignment must have 3 children");
                 TEXTX_ASSERT(match.children[0].captured.has_value(), "assignment name");
@@ -277,7 +278,7 @@ namespace {
                 else {
                     assignment_info << "assignment://" << attribute_name;
                 }
-                ta::Pattern assignment_rhs_content = ta::named(assignment_info.str(), ta::sequence({transform_match2pattern( parsestate, mm, rule, choice.children[0])})); 
+                te::Expression assignment_rhs_content = te::named(assignment_info.str(), te::sequence({transform_match2expression( parsestate, mm, rule, choice.children[0])})); 
 
                 // repeat modifiers
                 auto repeat_modifiers_match = match.children[2].children[1]; 
@@ -338,21 +339,21 @@ namespace {
                 }
                 else if (assignment_op=="*=") {
                     return std::visit(overloaded{
-                        [&](ta::Pattern&p) -> ta::Pattern { return ta::optional(ta::sequence({assignment_rhs_content, ta::zero_or_more(ta::sequence({p, assignment_rhs_content}))})); },
-                        [&](Eolterm&) -> ta::Pattern { return ta::eolterm(ta::zero_or_more(assignment_rhs_content)); },
-                        [&](None&) -> ta::Pattern { return ta::zero_or_more(assignment_rhs_content); }
+                        [&](te::Expression&p) -> te::Expression { return te::optional(te::sequence({assignment_rhs_content, te::zero_or_more(te::sequence({p, assignment_rhs_content}))})); },
+                        [&](Eolterm&) -> te::Expression { return te::eolterm(te::zero_or_more(assignment_rhs_content)); },
+                        [&](None&) -> te::Expression { return te::zero_or_more(assignment_rhs_content); }
                     }, repeat_modifiers);
                 }
                 else if (assignment_op=="+=") {
                     return std::visit(overloaded{
-                        [&](ta::Pattern&p) -> ta::Pattern { return ta::sequence({assignment_rhs_content, ta::zero_or_more(ta::sequence({p, assignment_rhs_content}))}); },
-                        [&](Eolterm&) -> ta::Pattern { return ta::eolterm(ta::one_or_more(assignment_rhs_content)); },
-                        [&](None&) -> ta::Pattern { return ta::one_or_more(assignment_rhs_content); }
+                        [&](te::Expression&p) -> te::Expression { return te::sequence({assignment_rhs_content, te::zero_or_more(te::sequence({p, assignment_rhs_content}))}); },
+                        [&](Eolterm&) -> te::Expression { return te::eolterm(te::one_or_more(assignment_rhs_content)); },
+                        [&](None&) -> te::Expression { return te::one_or_more(assignment_rhs_content); }
                     }, repeat_modifiers);
                 }
                 else if (assignment_op=="?=") {
                     TEXTX_ASSERT(std::holds_alternative<None>(repeat_modifiers),"no repeat modifiers allowed for a boolean assignment");
-                    return ta::optional(assignment_rhs_content);
+                    return te::optional(assignment_rhs_content);
                 }
                 else {
                     ta::raise(match.start(),"unexpected assignment_op");
@@ -361,30 +362,30 @@ namespace {
         },
         {
             "rule://rule_ref",
-            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> ta::Pattern {
+            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> te::Expression {
                 auto ref_rule_name = match.captured.value();
                 if (!parsestate.in_assignment) {
                     //std::cout << "rule " << rule.tx_name() << " add_tx_inh_by+= " << ref_rule_name << "\n";
                 }
-                return mm.ref(ref_rule_name);
+                return te::rule_ref(ref_rule_name);
             }
         },
         {
             "rule://obj_ref",
-            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> ta::Pattern {
+            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> te::Expression {
                 auto type_name = match.children[1].captured.value();
                 auto &optional_format = match.children[2];
                 std::string ref_rule_name = "ID";
                 if (optional_format.children.size()>0) {
                     ref_rule_name = optional_format.children[0].children[1].captured.value();
                 }
-                return named(std::string("obj_ref://")+type_name,ta::sequence({mm.ref(ref_rule_name)}));
+                return te::named(std::string("obj_ref://")+type_name,te::sequence({te::rule_ref(ref_rule_name)}));
             }
         },
         {
             "rule://reference",
-            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> ta::Pattern {
-                return transform_match2pattern(parsestate, mm, rule, match.children[0]);
+            [](ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) -> te::Expression {
+                return transform_match2expression(parsestate, mm, rule, match.children[0]);
             }
         },
     };
@@ -397,14 +398,14 @@ namespace {
             return Eolterm{};
         }
         else {
-            return transform_match2pattern(parsestate, mm, rule, second.children[0].children[0]);
+            return transform_match2expression(parsestate, mm, rule, second.children[0].children[0]);
         }
     }
 
-   ta::Pattern transform_match2pattern(ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) {
-        if (transform_match2pattern_map.count(match.name.value())==1) {
+   te::Expression transform_match2expression(ParseState parsestate, METAMODEL &mm, RULE& rule, const ta::Match& match) {
+        if (transform_match2expression_map.count(match.name.value())==1) {
             try {
-                return transform_match2pattern_map[match.name.value()](parsestate, mm, rule, match);
+                return transform_match2expression_map[match.name.value()](parsestate, mm, rule, match);
             }
             catch(ta::Exception& e) {
                 throw;
@@ -416,7 +417,7 @@ namespace {
             }
         }
         else {
-            ta::raise(match.start(), "unexpected: no entry in transform_match2pattern_map for ", match.name.value());
+            ta::raise(match.start(), "unexpected: no entry in transform_match2expression_map for ", match.name.value());
         }
     }
 }
@@ -456,13 +457,26 @@ namespace textx {
 
     void Rule::post_process_created_rule(textx::Metamodel& mm, std::string_view name, ta::Match rule_params, const ta::Match& rule_body) {
         auto& rule = *this;
-        rule.pattern = transform_match2pattern(ParseState{}, mm, rule, rule_body);
-        rule.intern_arpeggio_rule_body = &rule_body;
         std::string rname = std::string("rule://")+std::string(name);
+        rule.expression = te::named(rname, transform_match2expression(ParseState{}, mm, rule, rule_body), true);
+        rule.intern_arpeggio_rule_body = &rule_body;
         for(auto& [k,v]: attribute_info) {
             v.cardinality = get_attribute_cardinality(rule_body, k);
         }
-        rule.pattern = textx::arpeggio::rule(textx::arpeggio::named(rname,rule.pattern));
+    }
+
+    void Rule::compile(textx::Metamodel& mm) {
+        auto& rule = *this;
+        te::optimize(rule.expression, [&mm](const std::string& name) -> const Rule* {
+            try {
+                if (mm.has_rule(name, false)) {
+                    return &mm.find_rule(name, false);
+                }
+            }
+            catch(std::exception&) {} // unknown grammar: looked up during parsing (see Metamodel::ref)
+            return nullptr;
+        });
+        rule.pattern = te::to_pattern(rule.expression, mm);
         if (rule.tx_params().count("noskipws")>0) {
             TEXTX_ASSERT(rule.tx_params().count("skipws")==0);
             rule.pattern = textx::arpeggio::noskipws(rule.pattern);
@@ -613,6 +627,8 @@ namespace textx {
         for (auto &[name,info]: attribute_info) {
             info.adjust_type(mm);
         }
+        TEXTX_ASSERT(attribute_names.size()==attribute_info.size());
+        attribute_layout = std::make_shared<const textx::object::AttributeLayout>(attribute_names);
         // final check for boolean attr. to be "alone"
         for (auto &[name,info]: attribute_info) {
             if (info.maybe_boolean()) {
@@ -623,13 +639,14 @@ namespace textx {
 
     void AttributeInfo::adjust_type(const textx::Metamodel& mm) {
         // remove all match types + adjust maybe_str
-        auto rem_it = std::remove_if(
+        auto rem_it = std::stable_partition(
             types.begin(),
             types.end(),
-            [&mm](const std::string &rule_name){ return mm[rule_name].type()==RuleType::match; }
+            [&mm](const std::string &rule_name){ return mm[rule_name].type()!=RuleType::match; }
         );
         if (rem_it != types.end()) {
             m_maybe_str = true; // found possible match rule
+            match_types.insert(match_types.end(), rem_it, types.end());
             types.erase(rem_it, types.end());
         }
 
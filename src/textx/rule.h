@@ -2,6 +2,8 @@
 
 #include "textx/arpeggio.h"
 #include "textx/grammar.h"
+#include "textx/expression.h"
+#include "textx/object.h"
 #include <unordered_map>
 #include <string>
 #include <variant>
@@ -43,6 +45,7 @@ namespace textx {
         AttributeCardinality cardinality = AttributeCardinality::scalar;
         std::optional<std::string> type = std::nullopt;
         std::vector<std::string> types={};
+        std::vector<std::string> match_types={}; /// match rules assigned to the attribute ("" for string literals)
         bool m_maybe_str = false;
         bool m_maybe_obj = false;
         bool m_maybe_boolean = false;
@@ -90,8 +93,11 @@ namespace textx {
 
     class Rule {
         textx::arpeggio::Pattern pattern;
+        textx::expression::Expression expression; // intermediate representation of the rule (see compile)
         std::string name = "unnamed";
         std::unordered_map<std::string, AttributeInfo> attribute_info = {}; 
+        std::vector<std::string> attribute_names = {}; // in order of appearance
+        std::shared_ptr<const textx::object::AttributeLayout> attribute_layout = textx::object::AttributeLayout::empty(); // see adjust_attr_types
         std::unordered_set<std::string> m_tx_inh_by = {}; // for abstract rules 
         RuleType m_type = RuleType::illegal;
         std::unordered_map<std::string,std::string> m_tx_params = {};
@@ -100,9 +106,18 @@ namespace textx {
 
         Rule(const textx::Metamodel& mm, std::string_view name, textx::arpeggio::Match rule_params, const textx::arpeggio::Match& rule_body);
         void post_process_created_rule(textx::Metamodel& mm, std::string_view name, textx::arpeggio::Match rule_params, const textx::arpeggio::Match& rule_body);
+        /** optimize the expression and create the pattern (after all rules of the grammar have been post processed) */
+        void compile(textx::Metamodel& mm);
         textx::AttributeCardinality get_attribute_cardinality(const textx::arpeggio::Match& match, std::string name);
         void determine_rule_type_and_adjust_inh_by(const textx::Metamodel& mm);
         void adjust_attr_types(const textx::Metamodel& mm);
+        AttributeInfo& get_or_create_attribute_info(const std::string& name) {
+            auto [p, inserted] = attribute_info.try_emplace(name);
+            if (inserted) {
+                attribute_names.push_back(name);
+            }
+            return p->second;
+        }
 
         friend Metamodel;
     public:
@@ -110,14 +125,16 @@ namespace textx {
         RuleType type() const { return m_type; }
 
         void add_attribute_with_rule_type(std::string name, std::string type) {
-            attribute_info[name].types.push_back(type);
+            get_or_create_attribute_info(name).types.push_back(type);
             // do not decide if rule is an obj or a str (later!)
         }
         void add_attribute_with_str_type(std::string name) {
-            attribute_info[name].m_maybe_str = true;
+            auto &info = get_or_create_attribute_info(name);
+            info.m_maybe_str = true;
+            info.match_types.push_back("");
         }
         void add_attribute_with_boolean_type(std::string name) {
-            attribute_info[name].m_maybe_boolean = true;
+            get_or_create_attribute_info(name).m_maybe_boolean = true;
         }
         bool maybe_str() const { return m_maybe_str; }
 
@@ -131,6 +148,7 @@ namespace textx {
             return p->second;
         }
         const std::string& tx_name() const { return name; }
+        const textx::expression::Expression& tx_expression() const { return expression; }
 
         std::optional<textx::arpeggio::Match> operator()(const textx::arpeggio::Config &config, textx::arpeggio::ParserState &text, textx::arpeggio::TextPosition pos) const {
             return pattern(config, text, pos);
@@ -148,6 +166,23 @@ namespace textx {
             return attribute_info;
         }
 
+        /** attribute ids are the indices of the attribute names in order of appearance (= slots of the objects) */
+        const std::shared_ptr<const textx::object::AttributeLayout>& tx_attribute_layout() const { return attribute_layout; }
+        const std::vector<std::string>& tx_attribute_names() const { return attribute_layout->names; }
+        size_t tx_attribute_id(std::string_view name) const {
+            auto slot = attribute_layout->slot(name);
+            if (!slot.has_value()) {
+                throw std::runtime_error(std::string("cannot find attribute_info \"")+std::string(name)+"\"");
+            }
+            return slot.value();
+        }
+        const AttributeInfo& tx_attribute_info(size_t attr_id) const {
+            return attribute_info.at(tx_attribute_names().at(attr_id));
+        }
+        textx::object::AttrKey tx_attr_key(std::string_view name) const {
+            return {attribute_layout.get(), tx_attribute_id(name)};
+        }
+
         AttributeInfo& operator[](std::string name)
         {
             auto p = attribute_info.find(name);
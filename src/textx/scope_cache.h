@@ -0,0 +1,105 @@
+#pragma once
+
+#include "textx/object.h"
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+
+/**
+ * Results of scope searches of a model (see ModelOptions::cache_scope_results).
+ *
+ * The key is (resolver or expression, scope object, name, target type id),
+ * where the scope object is the object the search starts from: the model
+ * root for RREL expressions which do not start locally (all origins share the
+ * result), the origin otherwise, and each parent visited by the FQN search.
+ * Only final results are stored (no postponed searches). The cache is
+ * cleared with Model::reset_type_index (call it after modifying the model).
+ */
+namespace textx::scoping {
+
+    class ScopeCache {
+    public:
+        using Result = std::tuple<std::shared_ptr<textx::object::Object>, textx::object::MatchedPath>;
+        static constexpr textx::object::TypeId no_type = std::numeric_limits<textx::object::TypeId>::max();
+
+        std::optional<Result> find(const void* resolver, const textx::object::Object* scope, std::string_view name, textx::object::TypeId type) const {
+            {
+                std::shared_lock lock{mutex};
+                auto p = entries.find(KeyView{resolver, scope, name, type});
+                if (p!=entries.end()) {
+                    auto obj = p->second.obj.lock();
+                    if (obj!=nullptr || p->second.not_found) {
+                        n_hits++;
+                        return Result{obj, p->second.matched_path};
+                    }
+                }
+            }
+            n_misses++;
+            return std::nullopt;
+        }
+        void insert(const void* resolver, const textx::object::Object* scope, std::string_view name, textx::object::TypeId type, const Result& res) {
+            std::unique_lock lock{mutex};
+            auto &obj = std::get<0>(res);
+            entries.insert_or_assign(Key{resolver, scope, std::string{name}, type}, Entry{obj, std::get<1>(res), obj==nullptr});
+        }
+        void clear() {
+            std::unique_lock lock{mutex};
+            entries.clear();
+        }
+
+        size_t size() const {
+            std::shared_lock lock{mutex};
+            return entries.size();
+        }
+        size_t hits() const { return n_hits; }
+        size_t misses() const { return n_misses; }
+
+    private:
+        struct Key {
+            const void* resolver;
+            const textx::object::Object* scope;
+            std::string name;
+            textx::object::TypeId type;
+        };
+        struct KeyView {
+            const void* resolver;
+            const textx::object::Object* scope;
+            std::string_view name;
+            textx::object::TypeId type;
+            KeyView(const void* resolver, const textx::object::Object* scope, std::string_view name, textx::object::TypeId type) : resolver{resolver}, scope{scope}, name{name}, type{type} {}
+            KeyView(const Key& k) : resolver{k.resolver}, scope{k.scope}, name{k.name}, type{k.type} {}
+            bool operator==(const KeyView&) const = default;
+        };
+        struct KeyHash {
+            using is_transparent = void;
+            size_t operator()(const KeyView& k) const {
+                size_t h = std::hash<std::string_view>{}(k.name);
+                h ^= std::hash<const void*>{}(k.resolver) + 0x9e3779b97f4a7c15ULL + (h<<6) + (h>>2);
+                h ^= std::hash<const void*>{}(k.scope) + 0x9e3779b97f4a7c15ULL + (h<<6) + (h>>2);
+                h ^= k.type + 0x9e3779b97f4a7c15ULL + (h<<6) + (h>>2);
+                return h;
+            }
+        };
+        struct KeyEqual {
+            using is_transparent = void;
+            bool operator()(const KeyView& a, const KeyView& b) const { return a==b; }
+        };
+        struct Entry {
+            textx::object::Link<textx::object::Object> obj;
+            textx::object::MatchedPath matched_path;
+            bool not_found;
+        };
+
+        mutable std::shared_mutex mutex;
+        std::unordered_map<Key, Entry, KeyHash, KeyEqual> entries = {};
+        mutable std::atomic<size_t> n_hits = 0;
+        mutable std::atomic<size_t> n_misses = 0;
+    };
+}
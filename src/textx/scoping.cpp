@@ -1,5 +1,6 @@
 #include "textx/scoping.h"
 #include "textx/metamodel.h"
+#include "textx/workspace.h"
 #include "textx/arpeggio.h"
 #include <sstream>
 #include <iostream>
@@ -9,65 +10,40 @@ namespace textx::scoping {
     std::tuple<std::shared_ptr<textx::object::Object>, MatchedPath> PlainNameRefResolver::resolve(std::shared_ptr<textx::object::Object> origin, std::string obj_name, std::optional<std::string> target_type) const {
         auto m = origin->tx_model();
         auto mm = m->tx_metamodel();
+        std::optional<textx::object::TypeId> target_type_id = std::nullopt; // looked up on first use
 
-        std::function<std::shared_ptr<textx::object::Object>(textx::object::Value&)> traverse;
-        traverse = [&, this](textx::object::Value& v) -> std::shared_ptr<textx::object::Object> {
-            if (v.is_str()) {
-                // nothing
-            }
-            else if (v.is_ref()) {
-                // nothing
-            }
-            else if (v.is_boolean()) {
-                // nothing
-            }
-            else if (v.is_pure_obj()) {
-                // std::cout << "resolve ... " << v.obj()->type << "\n";
-                // if (v.obj()->has_attr("name")) {
-                //     std::cout << "name ='" <<(*v.obj())["name"].str()<< "' ==? '" << obj_name<<"'\n";
-                // }
-                if (!v.is_null() && v.obj()->has_attr("name") && (*v.obj())["name"].str()==obj_name) {
-                    if(target_type.has_value()) {
-                        //use master mm! 
-                        // no: auto &mm = *v.obj()->tx_model()->tx_metamodel();
-                        if (!mm->is_base_of(target_type.value(),v.obj()->type)) {
-                            textx::arpeggio::raise(v.obj()->pos,"'", obj_name, "' has not expected type '", target_type.value(), "'");
-                        }
-                    }
-                    //std::cout << "FOUND!" << obj_name << "\n";
-                    return v.obj();
-                } 
-                for (auto &[k,av]: v.obj()->attributes) {
-                    if (std::holds_alternative<textx::object::Value>(av.data)) {
-                        auto &the_value = std::get<textx::object::Value>(av.data);
-                        if (!the_value.is_null()) {
-                            auto p = traverse(the_value);
-                            if (p) return p;
-                        }
-                    }
-                    else {
-                        for (auto &iv: std::get<std::vector<textx::object::Value>>(av.data)) {
-                            auto p = traverse(iv);
-                            if (p) return p;
-                        }
-                    }
+        // the first object with the name in traversal order (see Model::objects_named):
+        auto search = [&](textx::Model& model) -> std::shared_ptr<textx::object::Object> {
+            auto &named = model.objects_named(obj_name);
+            return named.empty() ? nullptr : named.front();
+        };
+        auto check = [&](const std::shared_ptr<textx::object::Object>& p) {
+            if(target_type.has_value()) {
+                //use master mm! 
+                // no: auto &mm = *v.obj()->tx_model()->tx_metamodel();
+                if (!target_type_id.has_value()) {
+                    target_type_id = mm->type_id(target_type.value());
+                }
+                if (!mm->is_instance(*p, target_type_id.value())) {
+                    textx::arpeggio::raise(p->pos,"'", obj_name, "' has not expected type '", target_type.value(), "'");
                 }
             }
-            else {
-                textx::arpeggio::raise(v.pos, "unexpected situaltion (scoping)");
-            }
-
-            return nullptr;
+            return p;
         };
         // own model:
         {
-            auto p = traverse(m->val());
-            if (p) return {p, {}};
+            auto p = search(*m);
+            if (p) return {check(p), {}};
+        }
+        // imported/builtin models (the names of imports known to the workspace are looked up in its table):
+        if (auto workspace = m->tx_workspace()) {
+            auto p = workspace->tx_exported_symbols().find_name(obj_name, m->tx_imported_models(), search);
+            if (p) return {check(p), {}};
+            return {nullptr, {}};
         }
-        // imported/builtin models:
         for (auto im: m->tx_imported_models()) {
-            auto p = traverse(im.lock()->val());
-            if (p) return {p, {}};
+            auto p = search(*im.lock());
+            if (p) return {check(p), {}};
         }
         return {nullptr, {}};
     }
@@ -77,25 +53,68 @@ namespace textx::scoping {
         auto mm = m->tx_metamodel();
         auto v_obj_name = separate_name(obj_name);
 
+        // the search below each parent is cached (shared by all origins below the parent)
+        auto cache = m->tx_scope_cache();
+        auto type = ScopeCache::no_type;
+        if (cache!=nullptr && target_type.has_value()) type = mm->type_id(*target_type);
+        const textx::object::Object* first_scope = origin.get();
+        auto search = [&](const std::shared_ptr<textx::object::Object>& scope) {
+            if (cache==nullptr || scope.get()==first_scope) {
+                return dot_separated_name_search(scope, v_obj_name, target_type);
+            }
+            if (auto cached = cache->find(this, scope.get(), obj_name, type)) {
+                return std::get<0>(*cached);
+            }
+            auto res = dot_separated_name_search(scope, v_obj_name, target_type);
+            cache->insert(this, scope.get(), obj_name, type, {res, {}});
+            return res;
+        };
+
         // own model
         while(origin!=nullptr) {
-            auto res = dot_separated_name_search(origin, v_obj_name, target_type);
+            auto res = search(origin);
             if (res) return {res, {}};
             origin = origin->parent();
         }
-        // imported/builtin models:
+        // imported/builtin models (see PlainNameRefResolver):
+        auto search_root = [&](textx::Model& im) -> std::shared_ptr<textx::object::Object> {
+            return im.val().is_obj() ? search(im.val().obj()) : nullptr;
+        };
+        if (auto workspace = m->tx_workspace()) {
+            auto res = workspace->tx_exported_symbols().find_fqn(obj_name, m->tx_imported_models(), search_root);
+            if (res) return {dot_separated_name_search(res, v_obj_name, target_type, v_obj_name.size()), {}}; // type check
+            return {nullptr, {}};
+        }
         for (auto wim: m->tx_imported_models()) {
             auto im = wim.lock();
             if (im->val().is_obj()) {
                 origin = im->val().obj();
                 //std::cout << origin << "\n";
-                auto res = dot_separated_name_search(origin, v_obj_name, target_type);
+                auto res = search(origin);
                 if (res) return {res, {}};
             }
         }
         return {nullptr, {}};
     }
 
+    namespace {
+        thread_local BlockingReferences* current_blocking_references = nullptr;
+    }
+
+    BlockingReferences::BlockingReferences() : outer{current_blocking_references} {
+        current_blocking_references = this;
+    }
+
+    BlockingReferences::~BlockingReferences() {
+        current_blocking_references = outer;
+    }
+
+    void report_blocking_reference(const textx::object::ObjectRef& ref) {
+        if (current_blocking_references!=nullptr) {
+            current_blocking_references->refs.push_back(&ref);
+        }
+    }
+
     std::vector<std::string> separate_name(std::string obj_name) {
         std::istringstream f_obj_name{obj_name};
         TEXTX_ASSERT(obj_name.size()>0, "empty names are not allowed");
@@ -115,7 +134,7 @@ namespace textx::scoping {
         if (idx==v_obj_name.size()) {
             if(target_type.has_value()) {
                 auto &mm = *origin->tx_model()->tx_metamodel();
-                if (!mm.is_base_of(target_type.value(),origin->type)) {
+                if (!mm.is_instance(*origin, mm.type_id(target_type.value()))) {
                     textx::arpeggio::raise(origin->pos,"'", v_obj_name[idx-1], "' has not expected type '", target_type.value(), "'");
                 }
             }
@@ -123,24 +142,10 @@ namespace textx::scoping {
         }
         TEXTX_ASSERT(idx<v_obj_name.size());
  
-        auto check_obj_and_name=[&](auto &attr) {
-            return attr.is_pure_obj() && attr.obj()->has_attr("name") && attr["name"].is_str() && attr["name"].str()==v_obj_name[idx];
-        };
-
-        for(auto& [aname,attr]: origin->attributes) {
-            if (attr.is_null()) continue; // optional attributes (x=ID)?
-            if (check_obj_and_name(attr)) {
-                auto res = dot_separated_name_search(attr.obj(), v_obj_name, target_type, idx+1);
-                if (res) return res;
-            }
-            else if (attr.is_list()) {
-                for(size_t i=0;i<attr.size();i++) {
-                    if (check_obj_and_name(attr[i])) {
-                        auto res = dot_separated_name_search(attr[i].obj(), v_obj_name, target_type, idx+1);
-                        if (res) return res;
-                    }
-                }
-            }
+        auto children = origin->child_names(); // keeps the index alive
+        for (auto &child: children->named(v_obj_name[idx])) {
+            auto res = dot_separated_name_search(child, v_obj_name, target_type, idx+1);
+            if (res) return res;
         }
         return nullptr;
     }
@@ -27,6 +27,27 @@ namespace textx::scoping {
 
     using PostponedOrObject = std::variant<Postponed, std::shared_ptr<textx::object::Object>>;
 
+    /**
+     * Resolvers call report_blocking_reference for unresolved references which
+     * prevented a resolution (e.g., RREL navigation through a reference). The
+     * postponed reference is resolved again after the blocking reference has
+     * been resolved (see Metamodel::model_from_str).
+     */
+    void report_blocking_reference(const textx::object::ObjectRef& ref);
+
+    /** collects the reports of report_blocking_reference of this thread during its lifetime */
+    class BlockingReferences {
+        std::vector<const textx::object::ObjectRef*> refs = {};
+        BlockingReferences* outer = nullptr;
+        friend void report_blocking_reference(const textx::object::ObjectRef& ref);
+    public:
+        BlockingReferences();
+        ~BlockingReferences();
+        BlockingReferences(const BlockingReferences&) = delete;
+        BlockingReferences& operator=(const BlockingReferences&) = delete;
+        const std::vector<const textx::object::ObjectRef*>& get() const { return refs; }
+    };
+
     std::vector<std::string> separate_name(std::string obj_name);
     std::shared_ptr<textx::object::Object> dot_separated_name_search(std::shared_ptr<textx::object::Object> origin, const std::vector<std::string> &v_obj_name, std::optional<std::string> target_type, size_t idx=0);
     inline std::shared_ptr<textx::object::Object> dot_separated_name_search(std::shared_ptr<textx::object::Object> origin, std::string obj_name, std::optional<std::string> target_type=std::nullopt) {
@@ -4,6 +4,14 @@
 #include <exception>
 #include <utility>
 #include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <algorithm>
 
 namespace textx::utils
 {
@@ -16,9 +24,110 @@ namespace textx::utils
         }
     };    
 
+    /** transparent hash: allows to use string_view keys with unordered_map<std::string,...,string_hash,std::equal_to<>> */
+    struct string_hash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+    };
+
     template<class T, class U>
     bool is_instance(U& obj) { return dynamic_cast<T*>(&obj)!=nullptr; }
 
+    /**
+     * threads which are started once and reused by parallel_for (e.g. for the
+     * rounds of Metamodel::resolve_references); the calling thread takes part.
+     */
+    class ThreadPool {
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable wake, done;
+        const std::function<void(size_t)>* job = nullptr;
+        size_t n = 0, block = 1;
+        std::atomic<size_t> next = 0;
+        size_t generation = 0; // of the current job
+        size_t active = 0;     // workers still running the current job
+        bool stop = false;
+
+        void run() {
+            for (size_t b=next.fetch_add(block); b<n; b=next.fetch_add(block)) {
+                for (size_t i=b;i<std::min(n, b+block);i++) (*job)(i);
+            }
+        }
+        void work() {
+            size_t seen = 0;
+            while (true) {
+                {
+                    std::unique_lock lock{mutex};
+                    wake.wait(lock, [&]() { return stop || generation!=seen; });
+                    if (stop) return;
+                    seen = generation;
+                }
+                run();
+                std::lock_guard lock{mutex};
+                if (--active==0) done.notify_one();
+            }
+        }
+    public:
+        /** up to "threads" threads (0: one per core), including the calling thread */
+        explicit ThreadPool(size_t threads) {
+            if (threads==0) threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+            for (size_t t=1;t<threads;t++) workers.emplace_back([this]() { work(); });
+        }
+        ~ThreadPool() {
+            {
+                std::lock_guard lock{mutex};
+                stop = true;
+            }
+            wake.notify_all();
+            for (auto &t: workers) t.join();
+        }
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        size_t size() const { return workers.size()+1; }
+
+        /**
+         * calls f(i) for all i in [0,n) on the threads of the pool. The indices
+         * are handed out in blocks (use small blocks for expensive calls); f
+         * must not throw. Not reentrant (one call at a time per pool).
+         */
+        void parallel_for(size_t n, const std::function<void(size_t)>& f, size_t block=16) {
+            if (workers.empty() || n<=block) {
+                for (size_t i=0;i<n;i++) f(i);
+                return;
+            }
+            {
+                std::lock_guard lock{mutex};
+                job = &f;
+                this->n = n;
+                this->block = block;
+                next = 0;
+                active = workers.size();
+                generation++;
+            }
+            wake.notify_all();
+            run();
+            std::unique_lock lock{mutex};
+            done.wait(lock, [&]() { return active==0; });
+            job = nullptr;
+        }
+    };
+
+    /**
+     * calls f(i) for all i in [0,n) on up to "threads" threads (0: one per core,
+     * including the calling thread), which are started for this call only (see
+     * ThreadPool to reuse them). The indices are handed out in blocks (use
+     * small blocks for expensive calls); f must not throw.
+     */
+    inline void parallel_for(size_t n, size_t threads, const std::function<void(size_t)>& f, size_t block=16) {
+        if (threads==0) threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        threads = std::min(threads, (n+block-1)/block);
+        if (threads<=1) {
+            for (size_t i=0;i<n;i++) f(i);
+            return;
+        }
+        ThreadPool{threads}.parallel_for(n, f, block);
+    }
+
     /* adapted from https://www.scs.stanford.edu/~dm/blog/c++-coroutines.html
        (added for-each begin/end support and other minor points) */
     template <typename T>
@@ -2,9 +2,15 @@
 
 #include "textx/metamodel.h"
 #include "textx/model.h"
+#include "textx/exported_symbols.h"
 #include <unordered_map>
+#include <unordered_set>
 #include <filesystem>
+#include <fstream>
+#include <sstream>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <type_traits> // later: concepts for is_...
 
 namespace textx {
@@ -21,9 +27,38 @@ namespace textx {
         virtual std::shared_ptr<textx::Model> model_from_str(std::string model_text) = 0;
         virtual bool has_metamodelmodel_by_shortcut(std::string name) = 0;
         virtual std::shared_ptr<textx::Metamodel> get_metamodel_by_shortcut(std::string name) = 0;
+        /** Model::all_of for all known models of the workspace (ordered by filename) */
+        virtual std::vector<std::shared_ptr<textx::object::Object>> all_of(std::string_view type) = 0;
+        /** sum of Model::tx_memory_stats of all known models */
+        virtual MemoryStats tx_memory_stats() = 0;
+        /** exported names of all known models (used by the builtin resolvers for imported models) */
+        virtual ExportedSymbols& tx_exported_symbols() = 0;
+        /**
+         * reloads the known models whose files changed (modification time,
+         * then content hash) and resolves the references of the known models
+         * importing them (transitively) again. Either all changes are applied
+         * or none (if a file cannot be loaded or a reference cannot be
+         * resolved; the exception is rethrown).
+         * The new versions are loaded and all references are resolved aside
+         * (see StagedResolution); other threads using the workspace meanwhile
+         * see the published models. The results are committed at once under
+         * the lock of the known models; the imports and references of the
+         * importers are written in place by this commit (their objects must
+         * not be read concurrently with it). One refresh at a time.
+         * Returns the filenames of the reloaded models (sorted).
+         */
+        virtual std::vector<std::string> refresh() = 0;
+        /**
+         * serializes the lazy resolutions of the references of the models of
+         * this workspace (see ModelOptions::lazy_references); a resolution
+         * may resolve references of imported models recursively.
+         */
+        const std::shared_ptr<std::recursive_mutex>& tx_lazy_resolution_mutex() const { return lazy_resolution_mutex; }
 
         protected:
         friend Metamodel;
+        /** the workspace whose refresh loads models on this thread (propagated to the import threads, see Metamodel::load_import_graph) */
+        static inline thread_local const Workspace* current_refresh = nullptr;
         virtual void add_metamodel_for_extension(std::string n, std::shared_ptr<textx::Metamodel> m) = 0;
         virtual void add_known_model(std::string path, std::shared_ptr<textx::Model> m) = 0; 
         virtual void add_known_metamodel(std::string path, std::shared_ptr<textx::Metamodel> m) = 0; 
@@ -32,6 +67,9 @@ namespace textx {
         virtual std::shared_ptr<textx::Model> get_model(std::string filename) = 0;
         virtual std::shared_ptr<textx::Metamodel> get_metamodel(std::string filename) = 0;
         virtual std::shared_ptr<textx::Metamodel> metamodel_from_file(std::filesystem::path filename, std::optional<std::string> grammar=std::nullopt) = 0;
+
+        private:
+        std::shared_ptr<std::recursive_mutex> lazy_resolution_mutex = std::make_shared<std::recursive_mutex>(); // shared with the models (they may outlive the workspace)
     };
     template< template<class> class Ptr4DefaultMM=std::shared_ptr>
         // requires 
@@ -46,9 +84,32 @@ namespace textx {
 
         Ptr4DefaultMM<textx::Metamodel> default_metamodel = {};
         std::unordered_map<std::string, std::shared_ptr<textx::Metamodel>> extension_to_metamodel = {};
+        std::mutex known_models_mutex; // models are added concurrently while loading imports (see ModelOptions::import_threads)
         std::unordered_map<std::string, std::shared_ptr<textx::Model>> known_models;
+        // content of the known models when they were loaded (see refresh)
+        struct FileState {
+            size_t hash = 0;
+            std::optional<std::filesystem::file_time_type> mtime = std::nullopt; /// no file (e.g., model_from_str)
+        };
+        std::unordered_map<std::string, FileState> file_states;
+        static FileState file_state(const std::string& path, std::string_view text) {
+            std::error_code ec;
+            auto mtime = std::filesystem::last_write_time(path, ec);
+            return {std::hash<std::string_view>{}(text), ec ? std::nullopt : std::optional{mtime}};
+        }
+        // refresh: the new versions of the changed files (and their new imports) are
+        // loaded into the staging area and published together (known_models_mutex)
+        struct Staging {
+            std::unordered_set<std::string> replaced = {};  /// the changed files (the known models are hidden)
+            std::unordered_map<std::string, std::shared_ptr<textx::Model>> models = {};
+            std::unordered_map<std::string, FileState> file_states = {};
+        };
+        std::optional<Staging> staging = std::nullopt;
+        // the staging area is only seen by the loads of the refresh (other threads see the published models)
+        bool staged() const { return staging.has_value() && current_refresh==this; }
         std::unordered_map<std::string, std::shared_ptr<textx::Metamodel>> known_metamodels;
         std::unordered_map<std::string, std::shared_ptr<textx::Metamodel>> known_metamodels_by_shortcut;
+        ExportedSymbols exported_symbols;
         WorkspaceImpl() = default;
     public:
         static std::shared_ptr<WorkspaceImpl> create() { return std::shared_ptr<textx::WorkspaceImpl<Ptr4DefaultMM>>{new textx::WorkspaceImpl<Ptr4DefaultMM>{}}; }
@@ -65,7 +126,19 @@ namespace textx {
         }
         void add_known_model(std::string path, std::shared_ptr<textx::Model> m) override { 
             //std::cout << "adding " << path << "\n";
-            known_models[path]=m;
+            std::lock_guard lock{known_models_mutex};
+            if (staged()) {
+                staging->models[path] = m;
+                staging->file_states[path] = file_state(path, m->tx_text());
+                return;
+            }
+            auto &known = known_models[path];
+            if (known!=nullptr && known!=m) {
+                exported_symbols.remove(known.get());
+            }
+            known=m;
+            exported_symbols.add(m);
+            file_states[path] = file_state(path, m->tx_text());
         }
         void add_known_metamodel(std::string path, std::shared_ptr<textx::Metamodel> m) override { 
             known_metamodels[path]=m;
@@ -75,6 +148,11 @@ namespace textx {
             //std::cout << shared_from_this() << "--> known_metamodels_by_shortcut.size()==" << known_metamodels_by_shortcut.size() << "\n";
         }
         bool has_model(std::string filename) override {
+            std::lock_guard lock{known_models_mutex};
+            if (staged()) {
+                if (staging->models.count(filename)>0) return true;
+                if (staging->replaced.count(filename)>0) return false;
+            }
             return known_models.count(filename)>0;
         }
         bool has_metamodelmodel(std::string filename) override {
@@ -104,13 +182,181 @@ namespace textx {
                 return nullptr;
             }
         }
-        std::shared_ptr<textx::Model> get_model(std::string filename) override {
-            if (known_models.count(filename)) {
-                return known_models[filename]; // cached model
+        std::vector<std::shared_ptr<textx::object::Object>> all_of(std::string_view type) override {
+            std::vector<std::pair<std::string, std::shared_ptr<textx::Model>>> models;
+            {
+                std::lock_guard lock{known_models_mutex};
+                models.assign(known_models.begin(), known_models.end());
             }
-            else {
-                return nullptr;
+            std::sort(models.begin(), models.end(), [](auto &a, auto &b) { return a.first<b.first; });
+            std::vector<std::shared_ptr<textx::object::Object>> res;
+            for (auto &[filename, m]: models) {
+                if (type!="OBJECT" && !m->tx_metamodel()->has_rule(type, true)) continue; // e.g. model of another language
+                auto &objects = m->all_of(type);
+                res.insert(res.end(), objects.begin(), objects.end());
+            }
+            return res;
+        }
+        MemoryStats tx_memory_stats() override {
+            MemoryStats res;
+            std::lock_guard lock{known_models_mutex};
+            for (auto &[filename, m]: known_models) {
+                res += m->tx_memory_stats();
+            }
+            return res;
+        }
+        ExportedSymbols& tx_exported_symbols() override { return exported_symbols; }
+        std::vector<std::string> refresh() override {
+            // changed files (the content is only compared if the modification time changed)
+            std::vector<std::string> changed;
+            std::unordered_map<std::string, std::shared_ptr<textx::Model>> old_models;
+            {
+                std::lock_guard lock{known_models_mutex};
+                for (auto &[path, m]: known_models) {
+                    auto &state = file_states[path];
+                    if (!state.mtime.has_value()) continue;
+                    std::error_code ec;
+                    auto mtime = std::filesystem::last_write_time(path, ec);
+                    if (ec || mtime==state.mtime.value()) continue; // unchanged (or removed: kept)
+                    std::ifstream file(path);
+                    std::stringstream text;
+                    text << file.rdbuf();
+                    if (std::hash<std::string_view>{}(text.view())==state.hash) {
+                        state.mtime = mtime; // touched only
+                        continue;
+                    }
+                    changed.push_back(path);
+                    old_models[path] = m;
+                }
+            }
+            std::sort(changed.begin(), changed.end());
+            if (changed.empty()) return changed;
+
+            // the models importing a changed model (transitively, recorded when the imports were linked)
+            std::unordered_set<const textx::Model*> seen;
+            std::vector<std::shared_ptr<textx::Model>> affected;
+            for (auto &[path, m]: old_models) seen.insert(m.get());
+            for (auto &[path, m]: old_models) affected.push_back(m);
+            for (size_t i=0;i<affected.size();i++) {
+                for (auto &importer: affected[i]->tx_importers()) {
+                    if (seen.insert(importer.get()).second) affected.push_back(importer);
+                }
+            }
+            affected.erase(affected.begin(), affected.begin()+old_models.size()); // the importers
+
+            // load the new versions (staged: imports of other changed files are loaded once)
+            std::unordered_map<std::string, std::shared_ptr<textx::Model>> new_models;
+            auto discard = [&]() {
+                std::lock_guard lock{known_models_mutex};
+                staging.reset();
+            };
+            {
+                std::lock_guard lock{known_models_mutex};
+                staging = Staging{{changed.begin(), changed.end()}};
+            }
+            try {
+                current_refresh = this;
+                for (auto &path: changed) {
+                    auto mm = old_models[path]->tx_metamodel();
+                    TEXTX_ASSERT(mm!=nullptr);
+                    new_models[path] = mm->model_from_file(path, false, shared_from_this());
+                }
+                current_refresh = nullptr;
+            }
+            catch (...) {
+                current_refresh = nullptr;
+                discard();
+                throw;
+            }
+
+            // resolve the references of the new models and (staged, see StagedResolution) of the importers
+            textx::object::StagedResolution staged;
+            std::unordered_set<std::shared_ptr<textx::Model>> eager;
+            std::vector<std::shared_ptr<textx::Model>> lazy_importers;
+            size_t threads = 1; // the maximum of the models (0: one per core)
+            auto add_threads = [&](const std::shared_ptr<textx::Metamodel>& mm) {
+                auto t = mm->tx_model_options().resolver_threads;
+                threads = (t==0 || threads==0) ? 0 : std::max(threads, t);
+            };
+            {
+                std::lock_guard lock{known_models_mutex};
+                for (auto &[path, m]: staging->models) { // incl. new imports
+                    auto mm = m->tx_metamodel();
+                    TEXTX_ASSERT(mm!=nullptr);
+                    if (!mm->tx_model_options().lazy_references) {
+                        eager.insert(m);
+                        add_threads(mm);
+                    }
+                }
+            }
+            for (auto &importer: affected) {
+                auto mm = importer->tx_metamodel();
+                TEXTX_ASSERT(mm!=nullptr);
+                auto &imports = staged.imports[importer.get()];
+                for (auto &im: importer->tx_imported_models()) {
+                    auto p = std::find_if(changed.begin(), changed.end(), [&](auto &path) { return im.lock()==old_models[path]; });
+                    imports.push_back((p==changed.end()) ? im : std::weak_ptr<textx::Model>{new_models[*p]});
+                }
+                if (mm->tx_model_options().lazy_references) { // resolved on access after the commit
+                    lazy_importers.push_back(importer);
+                    continue;
+                }
+                for (auto &v: textx::object::tree(importer->val())) {
+                    if (v.is_ref()) staged.refs[&v.ref()] = {};
+                }
+                eager.insert(importer);
+                add_threads(mm);
+            }
+            try {
+                textx::Metamodel::resolve_references(eager, threads, &staged);
+            }
+            catch (...) {
+                discard();
+                throw;
+            }
+
+            // commit: link the importers to the new versions and publish the new models at once
+            {
+                std::scoped_lock lock{known_models_mutex, *tx_lazy_resolution_mutex()}; // incl. the lazy resolutions of the importers
+                for (auto &importer: affected) {
+                    for (auto &path: changed) {
+                        importer->replace_imported_model(old_models[path], new_models[path]);
+                    }
+                    if (auto cache = importer->tx_scope_cache()) cache->clear();
+                }
+                for (auto &[ref, target]: staged.refs) {
+                    ref->obj = target.obj;
+                    ref->objpath = std::move(target.objpath);
+                }
+                for (auto &importer: lazy_importers) {
+                    for (auto &v: textx::object::tree(importer->val())) {
+                        if (!v.is_ref()) continue;
+                        auto &ref = v.ref();
+                        ref.obj.reset();
+                        ref.objpath = {};
+                        ref.lazy.state = textx::object::LazyResolution::pending;
+                    }
+                }
+                for (auto &[path, m]: staging->models) {
+                    auto &known = known_models[path];
+                    if (known!=nullptr) exported_symbols.remove(known.get());
+                    known = m;
+                    exported_symbols.add(m);
+                    file_states[path] = staging->file_states[path];
+                }
+                staging.reset();
+            }
+            return changed;
+        }
+        std::shared_ptr<textx::Model> get_model(std::string filename) override {
+            std::lock_guard lock{known_models_mutex};
+            if (staged()) {
+                auto p = staging->models.find(filename);
+                if (p!=staging->models.end()) return p->second;
+                if (staging->replaced.count(filename)>0) return nullptr;
             }
+            auto p = known_models.find(filename);
+            return p==known_models.end() ? nullptr : p->second; // cached model
         }
         std::shared_ptr<textx::Model> model_from_file(std::filesystem::path filename, bool is_main_model=true) override {
             filename = std::filesystem::canonical(filename);
@@ -497,4 +497,33 @@ TEST_CASE("match_search", "[arpeggio]")
     auto test123 = match.value().search("TEST123");
     CHECK(test123 != nullptr);
     CHECK(test123->captured.value() == "C");
-}
\ No newline at end of file
+}
+TEST_CASE("str_choice", "[arpeggio]")
+{
+    using namespace textx::arpeggio;
+    Config config{};
+
+    auto p = str_choice({"forward", "for", "up"});
+    CHECK(p.type() == MatchType::ordered_choice);
+    auto match = test_parse(p, config, "  for x");
+    REQUIRE(match);
+    CHECK(match.value().type() == MatchType::ordered_choice);
+    CHECK(match.value().children[0].type() == MatchType::str_match);
+    CHECK(get_str("  for x", match.value()) == "for");
+    CHECK(get_str("up", test_parse(p, config, "up").value()) == "up");
+    CHECK(!test_parse(p, config, "down"));
+    CHECK(!test_parse(p, config, ""));
+}
+
+TEST_CASE("skip", "[arpeggio]")
+{
+    using namespace textx::arpeggio;
+    Config config{};
+
+    auto p = skip(raw::str_match("x"));
+    CHECK(p.type() == MatchType::str_match);
+    CHECK(test_parse(p, config, "  x").value().start().pos == 2);
+    CHECK(!test_parse(raw::str_match("x"), config, "  x"));
+    // like rule(): no skipping for optional/zero_or_more
+    CHECK(test_parse(skip(raw::optional(raw::str_match("y"))), config, "  x").value().start().pos == 0);
+}
@@ -0,0 +1,89 @@
+#include "catch.hpp"
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include "textx/codegen.h"
+#include "codegen/shapes.h" // generated from the grammar below
+
+namespace {
+    auto shapes_metamodel() {
+        return textx::metamodel_from_str(R"(
+        Model: shapes+=Shape lines*=Line 'colors' colors+=ID[','];
+        Shape: Circle | Rect;
+        Circle: 'circle' name=ID r=INT ('at' center=Point)?;
+        Rect: 'rect' name=ID w=NUMBER h=NUMBER filled?='filled';
+        Point: '(' x=INT ',' y=INT ')';
+        Line: 'line' from=[Shape] '->' to=[Shape] ('class' class=ID)? (':' tag=Tag)?;
+        Tag: STRING | Point;
+    )");
+    }
+}
+
+TEST_CASE("codegen_generated_header", "[textx/codegen]")
+{
+    auto mm = shapes_metamodel();
+    auto fn = std::filesystem::path(__FILE__).parent_path().append("codegen/shapes.h");
+    std::ifstream file(fn);
+    std::stringstream golden;
+    golden << file.rdbuf();
+    CHECK( textx::codegen::generate_cpp(*mm, {"shapes"}) == golden.str() );
+}
+
+TEST_CASE("codegen_build", "[textx/codegen]")
+{
+    auto mm = shapes_metamodel();
+    auto m = mm->model_from_str(R"(
+        circle c1 3 at (1,2)
+        rect r1 2.5 4 filled
+        circle c2 5
+        line c1 -> r1 class dashed
+        line r1 -> c2 : "tag"
+        line c2 -> c1 : (7,8)
+        colors red, green
+    )");
+    auto data = shapes::tx_build(m);
+    auto &root = *data->tx_root;
+
+    REQUIRE( root.shapes.size() == 3 );
+    auto c1 = root.shapes[0].as<shapes::Circle>();
+    REQUIRE( c1 != nullptr );
+    CHECK( c1->name == "c1" );
+    CHECK( c1->r == 3 );
+    REQUIRE( c1->center != nullptr );
+    CHECK( c1->center->y == 2 );
+    auto r1 = root.shapes[1].as<shapes::Rect>();
+    REQUIRE( r1 != nullptr );
+    CHECK( r1->w == 2.5 );
+    CHECK( r1->filled );
+    CHECK( root.shapes[2].as<shapes::Circle>()->center == nullptr );
+    CHECK( root.shapes[2].as<shapes::Rect>() == nullptr );
+    CHECK( shapes::Shape::tx_is(root.shapes[2].tx_type()) );
+    CHECK( !shapes::Tag::tx_is(root.shapes[2].tx_type()) );
+
+    REQUIRE( root.lines.size() == 3 );
+    CHECK( root.lines[0]->from == root.shapes[0] );
+    CHECK( root.lines[0]->to == root.shapes[1] );
+    CHECK( root.lines[0]->class_ == "dashed" );
+    CHECK( root.lines[1]->class_ == "" );
+    CHECK( root.lines[1]->tag->str() == "tag" );
+    CHECK( root.lines[2]->tag->obj()->type == "Point" );
+    CHECK( root.colors == std::vector<std::string>{"red", "green"} );
+
+    CHECK( data->tx_Circle.size() == 2 );
+    CHECK( data->tx_Point.size() == 2 );
+}
+
+TEST_CASE("codegen_default_namespace", "[textx/codegen]")
+{
+    auto mm = textx::metamodel_from_str(R"(
+        Model: 'x' x=Other;
+        Other: name=ID;
+    )");
+    CHECK( textx::codegen::generate_cpp(*mm).find("namespace model {") != std::string::npos );
+}
+
+TEST_CASE("codegen_rejects_imported_rules", "[textx/codegen]")
+{
+    auto mm = textx::metamodel_from_file(std::filesystem::path(__FILE__).parent_path().append("multi_metamodel/metamodel_provider3/A.tx"));
+    CHECK_THROWS_WITH( textx::codegen::generate_cpp(*mm), Catch::Contains("imported grammars are not supported") );
+}
@@ -0,0 +1,162 @@
+// generated by textx::codegen::generate_cpp (do not edit)
+#pragma once
+#include "textx/codegen.h"
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace shapes {
+
+    struct Circle;
+    struct Line;
+    struct Model;
+    struct Point;
+    struct Rect;
+    struct Shape;
+    struct Tag;
+
+    struct Circle : textx::codegen::GeneratedObject {
+        static constexpr textx::codegen::TypeTag tx_tag = 1;
+        std::string name = {};
+        long long r = 0;
+        Point* center = nullptr;
+
+        Circle() : textx::codegen::GeneratedObject{tx_tag} {}
+    };
+
+    struct Line : textx::codegen::GeneratedObject {
+        static constexpr textx::codegen::TypeTag tx_tag = 2;
+        textx::codegen::Ptr<Shape> from = nullptr;
+        textx::codegen::Ptr<Shape> to = nullptr;
+        std::string class_ = {};
+        const textx::object::Value* tag = nullptr;
+
+        Line() : textx::codegen::GeneratedObject{tx_tag} {}
+    };
+
+    struct Model : textx::codegen::GeneratedObject {
+        static constexpr textx::codegen::TypeTag tx_tag = 3;
+        std::vector<textx::codegen::Ptr<Shape>> shapes = {};
+        std::vector<Line*> lines = {};
+        std::vector<std::string> colors = {};
+
+        Model() : textx::codegen::GeneratedObject{tx_tag} {}
+    };
+
+    struct Point : textx::codegen::GeneratedObject {
+        static constexpr textx::codegen::TypeTag tx_tag = 4;
+        long long x = 0;
+        long long y = 0;
+
+        Point() : textx::codegen::GeneratedObject{tx_tag} {}
+    };
+
+    struct Rect : textx::codegen::GeneratedObject {
+        static constexpr textx::codegen::TypeTag tx_tag = 5;
+        std::string name = {};
+        double w = 0;
+        double h = 0;
+        bool filled = false;
+
+        Rect() : textx::codegen::GeneratedObject{tx_tag} {}
+    };
+
+    struct Shape {
+        static constexpr bool tx_is(textx::codegen::TypeTag tag) {
+            return tag==Circle::tx_tag || tag==Rect::tx_tag;
+        }
+    };
+
+    struct Tag {
+        static constexpr bool tx_is(textx::codegen::TypeTag tag) {
+            return tag==Point::tx_tag;
+        }
+    };
+
+    /** the generated objects of a model (see tx_build) */
+    struct tx_model {
+        std::shared_ptr<textx::Model> tx_source = nullptr; /// keeps the values of attributes with more than one type alive
+        Model* tx_root = nullptr;
+        std::deque<Circle> tx_Circle = {};
+        std::deque<Line> tx_Line = {};
+        std::deque<Model> tx_Model = {};
+        std::deque<Point> tx_Point = {};
+        std::deque<Rect> tx_Rect = {};
+    };
+
+    inline void tx_fill(Circle& o, const textx::object::Object& src, const textx::codegen::ObjectIndex& index) {
+        o.name = textx::codegen::get_str(src["name"]);
+        o.r = textx::codegen::get_int(src["r"]);
+        o.center = textx::codegen::get_obj<Point>(src["center"], index);
+    }
+
+    inline void tx_fill(Line& o, const textx::object::Object& src, const textx::codegen::ObjectIndex& index) {
+        o.from = textx::codegen::get_obj<Shape>(src["from"], index);
+        o.to = textx::codegen::get_obj<Shape>(src["to"], index);
+        o.class_ = textx::codegen::get_str(src["class"]);
+        o.tag = textx::codegen::get_value(src["tag"]);
+    }
+
+    inline void tx_fill(Model& o, const textx::object::Object& src, const textx::codegen::ObjectIndex& index) {
+        for (auto& v: src["shapes"]) o.shapes.push_back(textx::codegen::get_obj<Shape>(v, index));
+        for (auto& v: src["lines"]) o.lines.push_back(textx::codegen::get_obj<Line>(v, index));
+        for (auto& v: src["colors"]) o.colors.push_back(textx::codegen::get_str(v));
+    }
+
+    inline void tx_fill(Point& o, const textx::object::Object& src, const textx::codegen::ObjectIndex&) {
+        o.x = textx::codegen::get_int(src["x"]);
+        o.y = textx::codegen::get_int(src["y"]);
+    }
+
+    inline void tx_fill(Rect& o, const textx::object::Object& src, const textx::codegen::ObjectIndex&) {
+        o.name = textx::codegen::get_str(src["name"]);
+        o.w = textx::codegen::get_float(src["w"]);
+        o.h = textx::codegen::get_float(src["h"]);
+        o.filled = textx::codegen::get_bool(src["filled"]);
+    }
+
+    /** create the structs of all objects of a model (the source model must not be modified afterwards) */
+    inline std::unique_ptr<tx_model> tx_build(std::shared_ptr<textx::Model> source) {
+        auto res = std::make_unique<tx_model>();
+        res->tx_source = source;
+        textx::codegen::ObjectIndex index;
+        std::vector<const textx::object::Object*> src_Circle;
+        std::vector<const textx::object::Object*> src_Line;
+        std::vector<const textx::object::Object*> src_Model;
+        std::vector<const textx::object::Object*> src_Point;
+        std::vector<const textx::object::Object*> src_Rect;
+        textx::object::traverse(source->val(), [&](textx::object::Value& v) {
+            if (!v.is_pure_obj() || v.is_null()) return;
+            auto& obj = *v.obj();
+            if (obj.type=="Circle") {
+                index[&obj] = &res->tx_Circle.emplace_back();
+                src_Circle.push_back(&obj);
+            }
+            else if (obj.type=="Line") {
+                index[&obj] = &res->tx_Line.emplace_back();
+                src_Line.push_back(&obj);
+            }
+            else if (obj.type=="Model") {
+                index[&obj] = &res->tx_Model.emplace_back();
+                src_Model.push_back(&obj);
+            }
+            else if (obj.type=="Point") {
+                index[&obj] = &res->tx_Point.emplace_back();
+                src_Point.push_back(&obj);
+            }
+            else if (obj.type=="Rect") {
+                index[&obj] = &res->tx_Rect.emplace_back();
+                src_Rect.push_back(&obj);
+            }
+            else throw std::runtime_error("unexpected type "+obj.type);
+        });
+        for (size_t i=0; i<src_Circle.size(); i++) tx_fill(res->tx_Circle[i], *src_Circle[i], index);
+        for (size_t i=0; i<src_Line.size(); i++) tx_fill(res->tx_Line[i], *src_Line[i], index);
+        for (size_t i=0; i<src_Model.size(); i++) tx_fill(res->tx_Model[i], *src_Model[i], index);
+        for (size_t i=0; i<src_Point.size(); i++) tx_fill(res->tx_Point[i], *src_Point[i], index);
+        for (size_t i=0; i<src_Rect.size(); i++) tx_fill(res->tx_Rect[i], *src_Rect[i], index);
+        res->tx_root = textx::codegen::get_obj<Model>(source->val(), index);
+        return res;
+    }
+}
@@ -0,0 +1,106 @@
+#include "catch.hpp"
+#include <iostream>
+#include <sstream>
+#include "textx/expression.h"
+#include "textx/metamodel.h"
+
+namespace {
+    template<class T>
+    std::string str(const T& x) {
+        std::ostringstream o;
+        o << x;
+        return o.str();
+    }
+}
+
+TEST_CASE("expression_flatten", "[textx/expression]")
+{
+    namespace te = textx::expression;
+    auto e = te::named("rule://A", te::sequence({
+        te::sequence({te::str_match("a"), te::sequence({te::str_match("b")})}),
+        te::ordered_choice({te::str_match("c"), te::ordered_choice({te::str_match("d"), te::rule_ref("X")})}),
+    }));
+    CHECK(str(e) == "named(rule://A, @seq(@seq(@'a' @seq(@'b')) @choice(@'c' | @choice(@'d' | ref(X)))))");
+    te::flatten(e);
+    CHECK(str(e) == "named(rule://A, @seq(@'a' @'b' @choice(@'c' | @'d' | ref(X))))");
+
+    // the first child of a named expression keeps its type
+    auto a = te::named("assignment://x", te::sequence({te::rule_ref("ID")}));
+    te::flatten(a);
+    CHECK(str(a) == "named(assignment://x, @seq(ref(ID)))");
+}
+
+TEST_CASE("expression_merge_literals", "[textx/expression]")
+{
+    namespace te = textx::expression;
+    auto e = te::ordered_choice({te::str_match("a"), te::str_match("b"), te::rule_ref("X"), te::str_match("c")});
+    te::merge_literals(e);
+    CHECK(str(e) == "@choice(@lits('a'|'b') | ref(X) | @'c')");
+
+    auto only_literals = te::ordered_choice({te::str_match("up"), te::str_match("down")});
+    te::merge_literals(only_literals);
+    CHECK(str(only_literals) == "@lits('up'|'down')");
+}
+
+TEST_CASE("expression_hoist_common_prefixes", "[textx/expression]")
+{
+    namespace te = textx::expression;
+    auto e = te::named("rule://A", te::ordered_choice({
+        te::sequence({te::str_match("a"), te::str_match("b")}),
+        te::sequence({te::str_match("a"), te::str_match("c")}),
+        te::str_match("a"),
+        te::str_match("d"),
+    }));
+    te::hoist_common_prefixes(e);
+    te::flatten(e);
+    CHECK(str(e) == "named(rule://A, @choice(@seq(@'a' @choice(@'b' | @'c' | @seq())) | @'d'))");
+}
+
+TEST_CASE("expression_remove_unreachable", "[textx/expression]")
+{
+    namespace te = textx::expression;
+    auto e = te::ordered_choice({te::str_match("a"), te::optional(te::str_match("b")), te::str_match("c")});
+    te::remove_unreachable_alternatives(e);
+    CHECK(str(e) == "@choice(@'a' | @(@'b')?)");
+
+    std::unordered_map<std::string, te::Expression> rules = {
+        {"Model", te::named("rule://Model", te::one_or_more(te::rule_ref("Item")))},
+        {"Item", te::named("rule://Item", te::rule_ref("ID"))},
+        {"ID", te::named("rule://ID", te::regex_match("\\w+", true))},
+        {"Unused", te::named("rule://Unused", te::rule_ref("ID"))},
+    };
+    auto removed = te::remove_unreachable_rules(rules, {"Model"});
+    CHECK(removed == std::unordered_set<std::string>{"Unused"});
+    CHECK(rules.size() == 3);
+}
+
+TEST_CASE("expression_metamodel_optimized_rules", "[textx/expression]")
+{
+    auto mm = textx::metamodel_from_str(R"(
+        Model: commands+=Command;
+        Command: 'move' dir=Dir | 'move' 'to' x=INT | 'stop';
+        Dir: 'forward'|'up'|'down';
+    )");
+    // literal alternatives are merged; refs to small rules are inlined; common prefixes are hoisted; only rules are memoized
+    CHECK(str((*mm)["Dir"].tx_expression()) == "@named(rule://Dir, lits('forward'|'up'|'down'))");
+    CHECK(str((*mm)["Command"].tx_expression()) ==
+        "@named(rule://Command, choice(seq('move' choice(named(assignment://dir, seq(@named(rule://Dir, lits('forward'|'up'|'down')))) | "
+        "seq('to' named(assignment://x, seq(@named(rule://INT, choice(capture(/[-+]?[0-9]+\\b/)))))))) | 'stop'))");
+
+    auto m = mm->model_from_str("move up move to 3 stop move down");
+    REQUIRE(m->val()["commands"].size() == 4);
+    CHECK(m->val()["commands"][0]["dir"].str() == "up");
+    CHECK(m->val()["commands"][1]["x"].i() == 3);
+    CHECK(m->val()["commands"][3]["dir"].str() == "down");
+    CHECK_THROWS(mm->model_from_str("move left"));
+}
+
+TEST_CASE("expression_optimize_trace", "[textx/expression]")
+{
+    namespace te = textx::expression;
+    auto e = te::named("rule://A", te::ordered_choice({te::sequence({te::str_match("a")})}), true);
+    std::ostringstream trace;
+    te::optimize(e, [](const std::string&) { return nullptr; }, &trace);
+    CHECK_THAT(trace.str(), Catch::Matchers::Contains("[flatten]\n  before: @named(rule://A, @choice(@seq(@'a')))\n  after:  @named(rule://A, @choice(@'a'))"));
+    CHECK(str(e) == "@named(rule://A, choice('a'))");
+}
@@ -0,0 +1,89 @@
+#include "catch.hpp"
+#include "textx/metamodel.h"
+#include "textx/frozen.h"
+#include <thread>
+#include <atomic>
+
+TEST_CASE("frozen_model", "[textx/frozen]")
+{
+    auto mm = textx::metamodel_from_str(R"(
+        Model: shapes+=Shape connections*=Connection;
+        Shape: Point | Circle;
+        Point: 'point' name=ID x=INT y=INT;
+        Circle: 'circle' name=ID r=NUMBER filled?='filled';
+        Connection: 'connect' from=[Shape] 'to' to=[Shape] (label=STRING)?;
+    )");
+    auto m = mm->model_from_str(R"(
+        point p1 1 2
+        circle c1 2.5 filled
+        point p2 3 4
+        connect p1 to c1 "first"
+        connect c1 to p2
+    )");
+    auto frozen = m->freeze();
+    auto &root = frozen->root();
+
+    CHECK( root.type() == "Model" );
+    REQUIRE( root["shapes"].size() == 3 );
+    auto &p1 = *root["shapes"][0].obj();
+    CHECK( p1.type() == "Point" );
+    CHECK( p1["name"].str_view() == "p1" );
+    CHECK( p1["y"].i() == 2 );
+    CHECK( p1.parent() == &root );
+    CHECK( root["shapes"][1]["r"].f() == 2.5 );
+    CHECK( root["shapes"][1]["filled"].boolean() );
+    CHECK( !root["shapes"][2]["name"].is_number() );
+
+    // references are direct pointers into the snapshot
+    CHECK( root["connections"][0]["from"].is_ref() );
+    CHECK( root["connections"][0]["from"].obj() == &p1 );
+    CHECK( root["connections"][1]["to"].obj() == root["shapes"][2].obj() );
+    CHECK( root["connections"][0]["label"].str() == "first" );
+    CHECK( root["connections"][1]["label"].str() == "" );
+
+    // type queries
+    CHECK( frozen->all_of("Shape").size() == 3 );
+    CHECK( frozen->all_of("Point").size() == 2 );
+    CHECK( frozen->is_instance(p1, frozen->type_id("Shape")) );
+    CHECK( !frozen->is_instance(p1, frozen->type_id("Circle")) );
+    CHECK( p1[mm->find_rule("Point", false).tx_attr_key("x")].i() == 1 );
+    CHECK_THROWS( p1["unknown"] );
+
+    // the snapshot is independent of the model
+    (*m)["shapes"][0]["name"] = textx::object::AttributeValue{textx::object::Value{textx::object::MatchText{"changed", "ID"}, {}}};
+    auto frozen2 = m->freeze();
+    (*m)["shapes"][0]["name"] = textx::object::AttributeValue{textx::object::Value{textx::object::MatchText{"again", "ID"}, {}}};
+    m.reset();
+    CHECK( p1["name"].str() == "p1" );
+    CHECK( frozen2->root()["shapes"][0]["name"].str() == "changed" ); // copied from the value
+    CHECK( frozen->objects().size() == 6 );
+}
+
+TEST_CASE("frozen_model_concurrent_reads", "[textx/frozen]")
+{
+    auto mm = textx::metamodel_from_str(R"(
+        Model: points+=Point refs+=Ref;
+        Point: 'point' name=ID x=INT;
+        Ref: 'ref' p=[Point];
+    )");
+    std::string text;
+    for (int i=0;i<100;i++) text += "point p"+std::to_string(i)+" "+std::to_string(i)+"\n";
+    for (int i=0;i<100;i++) text += "ref p"+std::to_string(99-i)+"\n";
+    auto frozen = mm->model_from_str(text)->freeze();
+
+    std::atomic<long long> total = 0;
+    std::vector<std::thread> threads;
+    for (int t=0;t<4;t++) {
+        threads.emplace_back([&]() {
+            long long sum = 0;
+            for (int n=0;n<100;n++) {
+                for (auto &r: frozen->root()["refs"]) {
+                    sum += r["p"]["x"].i();
+                }
+            }
+            total += sum;
+        });
+    }
+    for (auto &t: threads) t.join();
+    CHECK( total == 4*100*(99*100/2) );
+}
@@ -594,3 +594,48 @@ TEST_CASE("metamodel_abstract_rules_with_sequences_of_rules_only_using_the_first
     CHECK( !mm->is_instance("S6","Base") );
     CHECK( (*mm)["Base"].tx_inh_by().size()==4 );
 }
+
+TEST_CASE("metamodel_type_ids", "[textx/model]")
+{
+    auto grammar1 = R"(
+        Model: shapes+=Shape;
+        Shape: Point | Composite;
+        Composite: Group | Line;
+        Point: 'point' name=ID;
+        Group: 'group' name=ID '{' shapes*=Shape '}';
+        Line: 'line' name=ID;
+    )";
+    auto mm = textx::metamodel_from_str(grammar1);
+    CHECK( mm->type_id("OBJECT") == 0 );
+    CHECK( mm->type_id("Shape") != mm->type_id("Point") );
+    CHECK( mm->type_id("Point") == mm->type_id(mm->find_rule("Point", true)) );
+    CHECK( mm->type_id("INT") > 0 ); // rules of the imported BUILTIN metamodel
+    CHECK_THROWS( mm->type_id("Unknown") );
+
+    auto shape = mm->type_id("Shape");
+    auto composite = mm->type_id("Composite");
+    auto line = mm->type_id("Line");
+    CHECK( mm->is_instance(line, composite) );
+    CHECK( mm->is_instance(line, shape) ); // transitive
+    CHECK( mm->is_instance(line, line) );
+    CHECK( mm->is_instance(line, 0) );
+    CHECK( !mm->is_instance(composite, line) );
+    CHECK( !mm->is_instance(mm->type_id("Point"), composite) );
+    CHECK( mm->is_base_of(shape, line) );
+
+    // same results as with tx_inh_by
+    for (auto& special: mm->tx_all_types()) {
+        for (auto& base: mm->tx_all_types()) {
+            bool expected = special==base || (*mm)[base].tx_inh_by().count(special)>0;
+            CHECK( mm->is_instance(mm->type_id(special), mm->type_id(base)) == expected );
+        }
+    }
+
+    auto m = mm->model_from_str("point p group g { line l }");
+    auto l = m->fqn("g.l");
+    CHECK( l->type_space == mm->tx_type_space() );
+    CHECK( l->type_id == line );
+    CHECK( mm->is_instance(*l, shape) );
+    CHECK( !mm->is_instance(*l, mm->type_id("Point")) );
+    CHECK( l->is_instance("Composite") );
+}
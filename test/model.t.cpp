@@ -2,6 +2,7 @@
 #include <iostream>
 #include <sstream>
 #include "textx/metamodel.h"
+#include "textx/workspace.h"
 
 TEST_CASE("model_simple1", "[textx/model]")
 {
@@ -255,4 +256,415 @@ TEST_CASE("model_boolean_assignment_with_alternatives", "[textx/model]")
     )";
     CHECK_THROWS_WITH(textx::metamodel_from_str(grammar2), Catch::Matchers::Contains("boolean assignments must be alone"));
 
-}
\ No newline at end of file
+}
+TEST_CASE("model_attribute_slots", "[textx/model]")
+{
+    auto grammar1 = R"(
+        Model: points+=Point;
+        Point: 'point' name=ID '(' x=NUMBER ',' y=NUMBER ')' (visible?='visible')?;
+    )";
+    auto mm = textx::metamodel_from_str(grammar1);
+    auto& point_rule = mm->find_rule("Point", true);
+    CHECK( point_rule.tx_attribute_names() == std::vector<std::string>{"name", "x", "y", "visible"} ); // order of appearance
+    auto x = point_rule.tx_attr_key("x");
+    CHECK_THROWS( point_rule.tx_attr_key("z") );
+
+    auto m = mm->model_from_str("point A(1,2) point B(3,4) visible");
+    auto b = m->fqn("B");
+    CHECK( b->attributes.size() == 4 );
+    CHECK( (*b)[x].str() == "3" );
+    CHECK( &(*b)[x] == &(*b)["x"] );
+    CHECK( &(*b)[b->attr_key("visible")] == &(*b)["visible"] );
+    CHECK( (*b)["visible"].boolean() );
+    CHECK( b->has_attr("y") );
+    CHECK( !b->has_attr("z") );
+    CHECK_THROWS( (*b)["z"] );
+
+    std::vector<std::string> names;
+    for (auto& [name, value]: b->attributes) {
+        names.push_back(name);
+        CHECK( &value == &(*b)[name] );
+    }
+    CHECK( names == point_rule.tx_attribute_names() );
+
+    // objects w/o rule layout
+    textx::object::Object obj{nullptr, {}};
+    obj.create_attribute_if_not_present("b");
+    obj.create_attribute_if_not_present("name");
+    obj.create_attribute_if_not_present("b");
+    CHECK( obj.attributes.size() == 2 );
+    CHECK( obj.has_attr("name") );
+    obj[point_rule.tx_attr_key("name")].append(textx::object::Value{true, {}}); // other layout: by name
+    CHECK( obj["name"].size() == 1 );
+    CHECK( obj["b"].size() == 0 );
+}
+
+TEST_CASE("model_object_footprint", "[textx/model]")
+{
+    using textx::object::Object;
+    using textx::object::AttributeValue;
+    using textx::object::Value;
+    auto mm = textx::metamodel_from_str(R"(
+        Model: items+=Item;
+        Item: 'item' name=ID;
+    )");
+    std::string text;
+    for (size_t i=0;i<1000;i++) text += "item i"+std::to_string(i)+" ";
+    auto m = mm->model_from_str(text);
+    auto &items = std::get<std::vector<Value>>((*m)["items"].data);
+    auto &rule_layout = mm->find_rule("Item", true).tx_attribute_layout();
+    CHECK( std::all_of(items.begin(), items.end(), [&](auto &item) { return item.obj()->attributes.layout()==rule_layout; }) );
+
+    // per object: the object (w/ reference counters) and one slot per attribute, nothing per layout
+    constexpr size_t control_block = 2*sizeof(void*);
+    auto stats = m->tx_memory_stats();
+    CHECK( stats.objects.bytes == (items.size()+1)*(control_block+sizeof(Object)+sizeof(AttributeValue))+items.capacity()*sizeof(Value) );
+
+    // added attributes: one shared extension of the layout
+    for (auto &item: items) item.obj()->create_attribute_if_not_present("extra");
+    auto &extended = items[0].obj()->attributes.layout();
+    CHECK( extended->base==rule_layout );
+    CHECK( std::all_of(items.begin(), items.end(), [&](auto &item) { return item.obj()->attributes.layout()==extended; }) );
+    auto stats2 = m->tx_memory_stats();
+    CHECK( stats2.objects.bytes-stats.objects.bytes-items.size()*sizeof(AttributeValue) < 1000 );
+
+    // precomputed keys of the rule layout stay valid for the extensions
+    auto name = mm->find_rule("Item", true).tx_attr_key("name");
+    CHECK( &(*items[0].obj())[name] == &items[0].obj()->attributes.at_slot(name.slot) );
+    CHECK( (*items[0].obj())[name].str() == "i0" );
+}
+
+TEST_CASE("model_arena", "[textx/model]")
+{
+    auto grammar1 = R"(
+        Model: packages+=Package uses+=Use;
+        Package: 'package' name=ID '{' items*=Item '}';
+        Item: 'item' name=ID;
+        Use: 'use' item=[Item|FQN];
+        FQN: ID ('.' ID)*;
+    )";
+    auto mm = textx::metamodel_from_str(grammar1);
+    mm->set_resolver("Use.item", std::make_unique<textx::scoping::FQNRefResolver>());
+    mm->set_model_options({.use_arena=true, .arena_initial_size=1024});
+    auto m = mm->model_from_str("package P { item A item B } package Q { item A } use P.B use Q.A");
+    CHECK( m->tx_uses_arena() );
+    CHECK( m->tx_arena_object_count() == 8 );
+
+    auto b = m->fqn("P.B");
+    REQUIRE( b != nullptr );
+    CHECK( b.use_count() == 0 ); // non-owning
+    CHECK( b->parent() == m->fqn("P") );
+    CHECK( b->tx_model().get() == m.get() );
+    CHECK( (*m)["uses"][0]["item"].obj() == b );
+    CHECK( (*m)["uses"][1]["item"].obj() == m->fqn("Q.A") );
+    CHECK( (*m)["uses"][1]["item"].obj()->parent()->is_instance("Package") );
+
+    mm->set_model_options({});
+    auto m2 = mm->model_from_str("package P { item B } use P.B");
+    CHECK( !m2->tx_uses_arena() );
+    CHECK( m2->fqn("P.B").use_count() > 0 );
+}
+
+TEST_CASE("model_memory_stats", "[textx/model]")
+{
+    auto mm = textx::metamodel_from_str(R"(
+        Model: packages+=Package uses+=Use;
+        Package: 'package' name=ID '{' items*=Item '}';
+        Item: 'item' name=ID;
+        Use: 'use' item=[Item|FQN];
+        FQN: ID ('.' ID)*;
+    )");
+    mm->set_resolver("Use.item", std::make_unique<textx::scoping::FQNRefResolver>());
+    std::string text = "package first_package { item item_a item item_b } package Q { item A } use first_package.item_b use Q.A";
+    auto m = mm->model_from_str(text);
+    auto stats = m->tx_memory_stats();
+    CHECK( stats.memo_tables.bytes == 0 ); // not collected
+    CHECK( stats.parse_tree.bytes == 0 );
+    CHECK( stats.objects.allocations >= 8 );
+    CHECK( stats.strings.bytes > text.size() );
+    CHECK( stats.references.bytes == 0 ); // the names are views into the model text (no matched paths w/o RREL)
+    CHECK( stats.total().bytes == stats.retained().bytes );
+
+    mm->set_model_options({.collect_parse_memory_stats=true});
+    auto m2 = mm->model_from_str(text);
+    auto stats2 = m2->tx_memory_stats();
+    CHECK( stats2.memo_tables.bytes > 0 );
+    CHECK( stats2.memo_tables.allocations > 0 );
+    CHECK( stats2.parse_tree.bytes > 0 );
+    CHECK( stats2.objects.bytes == stats.objects.bytes );
+    CHECK( stats2.total().bytes > stats2.retained().bytes );
+
+    // more objects: more memory
+    auto m3 = mm->model_from_str(text+" use first_package.item_a");
+    CHECK( m3->tx_memory_stats().objects.bytes > stats.objects.bytes );
+    CHECK( m3->tx_memory_stats().strings.bytes > stats.strings.bytes );
+
+    // arena objects (and their attribute slots) are not allocated one by one
+    mm->set_model_options({.use_arena=true});
+    auto arena_stats = mm->model_from_str(text)->tx_memory_stats();
+    CHECK( arena_stats.objects.allocations < stats.objects.allocations );
+    CHECK( stats.objects.allocations - arena_stats.objects.allocations == 2*8-1 ); // 8 objects and their slots, plus the list of the arena objects
+
+    std::ostringstream dump;
+    stats2.print(dump, "model.");
+    CHECK( dump.str().starts_with("model.memo_tables bytes="+std::to_string(stats2.memo_tables.bytes)+" allocations=") );
+    CHECK( dump.str().find("\nmodel.total bytes="+std::to_string(stats2.total().bytes)) != std::string::npos );
+
+    // workspace: sum of the known models
+    mm->set_model_options({});
+    auto m4 = mm->model_from_str(text, "m4.model");
+    auto m5 = mm->model_from_str(text+" use Q.A", "m5.model");
+    auto ws_stats = mm->tx_default_workspace()->tx_memory_stats();
+    CHECK( ws_stats.objects.bytes == m4->tx_memory_stats().objects.bytes+m5->tx_memory_stats().objects.bytes );
+}
+
+TEST_CASE("model_number_conversion", "[textx/model]")
+{
+    using textx::object::MatchText;
+    using textx::object::TextType;
+    CHECK( MatchText{"12", "INT"}.type == TextType::INT );
+    CHECK( MatchText{"x", "ID"}.type == TextType::ID );
+    CHECK( MatchText{"x", "MyRule"}.type == TextType::other );
+    CHECK( MatchText{"12", "MyRule"}.scalar == textx::object::Scalar::none );
+
+    // same results as std::stoll(..., 0) and std::stold (converted numbers are stored as double)
+    for (std::string text: {"0", "12", "+12", "-12", "007", "0x1F", "-0", "1.5", "-1.5e3", "+.5", ".5", "1e5", "5.", "1e", "", "+-1", "-", "99999999999999999999", "1e99999"}) {
+        INFO( text );
+        textx::object::Value v{MatchText{text, "NUMBER"}, {}};
+        bool stoll_ok = true;
+        long long i = 0;
+        try { i = std::stoll(text, nullptr, 0); } catch(std::exception&) { stoll_ok=false; }
+        if (stoll_ok) { CHECK( v.i() == i ); } else { CHECK_THROWS( v.i() ); }
+        bool stold_ok = true;
+        long double f = 0;
+        try { f = std::stold(text); } catch(std::exception&) { stold_ok=false; }
+        if (stold_ok) { CHECK( v.f() == f ); } else { CHECK_THROWS( v.f() ); }
+        bool stoull_ok = true;
+        unsigned long long u = 0;
+        try { u = std::stoull(text, nullptr, 0); } catch(std::exception&) { stoull_ok=false; }
+        if (stoull_ok) { CHECK( v.u() == u ); } else { CHECK_THROWS( v.u() ); }
+    }
+
+    auto mm = textx::metamodel_from_str(R"(
+        Model: values+=Value;
+        Value: 'v' i=INT f=FLOAT n=NUMBER;
+    )");
+    auto m = mm->model_from_str("v 42 1.25 -3 v -7 .5 2e3");
+    CHECK( (*m)["values"][0]["i"].i() == 42 );
+    CHECK( (*m)["values"][0]["f"].f() == 1.25 );
+    CHECK( (*m)["values"][0]["n"].i() == -3 );
+    CHECK( (*m)["values"][1]["i"].i() == -7 );
+    CHECK( (*m)["values"][1]["f"].f() == 0.5 );
+    CHECK( (*m)["values"][1]["n"].f() == 2000 );
+    CHECK( (*m)["values"][1]["n"].is_number() );
+    CHECK( std::get<MatchText>(std::get<textx::object::Value>((*m)["values"][0]["i"].data).data).scalar == textx::object::Scalar::integer );
+    CHECK( std::get<MatchText>(std::get<textx::object::Value>((*m)["values"][1]["n"].data).data).scalar == textx::object::Scalar::floating );
+    CHECK( sizeof(MatchText) <= 32 );
+
+    // BOOL is converted once
+    auto mm_bool = textx::metamodel_from_str(R"(
+        Model: flags+=BOOL;
+    )");
+    auto m_bool = mm_bool->model_from_str("true False 1 0 True false");
+    std::vector<bool> expected = {true, false, true, false, true, false};
+    for (size_t i=0;i<expected.size();i++) {
+        INFO( i );
+        CHECK( std::get<MatchText>((*m_bool)["flags"][i].data).scalar == textx::object::Scalar::boolean );
+        CHECK( (*m_bool)["flags"][i].boolean() == expected[i] );
+        CHECK( !(*m_bool)["flags"][i].is_boolean() ); // still text
+    }
+    textx::object::Value id{MatchText{"x", "ID"}, {}};
+    CHECK_THROWS( id.boolean() );
+}
+
+TEST_CASE("model_string_views", "[textx/model]")
+{
+    auto mm = textx::metamodel_from_str(R"(
+        Model: 'model' name=ID values+=Value;
+        Value: 'v' s=STRING n=INT;
+    )");
+    auto m = mm->model_from_str("model Hello v \"abc\" 1 v 'x y' 2");
+    auto &text = m->tx_text();
+    auto in_text = [&](std::string_view v) {
+        return v.data()>=text.data() && v.data()+v.size()<=text.data()+text.size();
+    };
+    CHECK( (*m)["name"].str_view() == "Hello" );
+    CHECK( in_text((*m)["name"].str_view()) );
+    CHECK( (*m)["values"][0]["s"].str_view() == "abc" );
+    CHECK( in_text((*m)["values"][0]["s"].str_view()) );
+    CHECK( (*m)["values"][1]["s"].str() == "x y" );
+    CHECK( in_text((*m)["values"][1]["n"].str_view()) );
+    CHECK( std::get<textx::object::MatchText>(std::get<textx::object::Value>((*m)["values"][0]["s"].data).data).rule() == "STRING" );
+
+    // values not taken from the model text own a copy
+    textx::object::Value v{textx::object::MatchText{std::string("tmp"), "ID"}, {}};
+    auto copy = v;
+    CHECK( copy.str_view().data() != v.str_view().data() );
+    v = textx::object::Value{false, {}};
+    CHECK( copy.str_view() == "tmp" );
+    auto moved = std::move(copy);
+    CHECK( moved.str_view() == "tmp" );
+    CHECK( textx::object::MatchText{"'tmp'", "STRING"}.text() == "tmp" );
+    CHECK( textx::object::MatchText{"'it\\'s'", "STRING"}.text() == "it's" );
+}
+
+TEST_CASE("model_string_escapes", "[textx/model]")
+{
+    auto mm = textx::metamodel_from_str(R"(
+        Model: values+=STRING;
+    )");
+    auto m = mm->model_from_str(R"("a\"b" 'it\'s' "x\ny\tz" "back\\slash" "keep\q" "plain")");
+    CHECK( (*m)["values"][0].str() == "a\"b" );
+    CHECK( (*m)["values"][1].str() == "it's" );
+    CHECK( (*m)["values"][2].str() == "x\ny\tz" );
+    CHECK( (*m)["values"][3].str() == "back\\slash" );
+    CHECK( (*m)["values"][4].str() == "keep\\q" );
+    CHECK( (*m)["values"][5].str() == "plain" );
+
+    // only the escaped strings are copied (owned by the model)
+    auto &text = m->tx_text();
+    auto in_text = [&](std::string_view v) {
+        return v.data()>=text.data() && v.data()+v.size()<=text.data()+text.size();
+    };
+    CHECK( !in_text((*m)["values"][0].str_view()) );
+    CHECK( in_text((*m)["values"][5].str_view()) );
+    auto stats = m->tx_memory_stats();
+    auto m2 = mm->model_from_str(R"("a\"b" 'it\'s' "x\ny\tz" "back\\slash" "keep\q" "plain")");
+    CHECK( m2->tx_memory_stats().strings.bytes == stats.strings.bytes );
+    CHECK( (*m2)["values"][0].str_view().data() != (*m)["values"][0].str_view().data() );
+}
+
+TEST_CASE("model_path_query", "[textx/model]")
+{
+    auto mm = textx::metamodel_from_str(R"(
+        Model: points+=Point lines*=Line;
+        Point: 'point' name=ID x=INT y=INT;
+        Line: 'line' from=Point to=Point;
+    )");
+    auto m = mm->model_from_str("point a 1 2 point b 3 4 line point c 5 6 point d 7 8");
+
+    textx::object::PathQuery points{"points"};
+    auto res = m->query(points);
+    CHECK( res.is_list() );
+    CHECK( res.size() == 2 );
+    CHECK( &res.values()[1] == &(*m)["points"][1] ); // no copy
+    std::string names;
+    for (auto &p: res) names += p["name"].str();
+    CHECK( names == "ab" );
+
+    textx::object::PathQuery x{"lines[0].to.x"};
+    CHECK( m->query(x).i() == 7 );
+    CHECK( m->query(x).size() == 1 );
+    CHECK( m->query(textx::object::PathQuery{"points[1]"}).obj() == (*m)["points"][1].obj() );
+    const auto& cobj = *m->val().obj();
+    CHECK( x(cobj).str_view() == "7" );
+
+    CHECK( m->fqn_attributes("lines[0].from.name").str() == "c" );
+    CHECK( m->fqn_attributes("points").size() == 2 );
+    CHECK_THROWS( m->query(textx::object::PathQuery{"points[2]"}) );
+    CHECK_THROWS( textx::object::PathQuery{"points[1"} );
+}
+
+TEST_CASE("model_type_index", "[textx/model]")
+{
+    auto mm = textx::metamodel_from_str(R"(
+        Model: shapes+=Shape;
+        Shape: Circle | Polygon;
+        Polygon: Rect | Triangle;
+        Circle: 'circle' name=ID;
+        Rect: 'rect' name=ID;
+        Triangle: 'triangle' name=ID;
+    )");
+    auto m = mm->model_from_str("circle a rect b triangle c rect d");
+    auto names = [](auto &objects) {
+        std::string res;
+        for (auto &o: objects) res += (*o)["name"].str();
+        return res;
+    };
+    CHECK( names(m->all_of("Rect")) == "bd" );
+    CHECK( names(m->all_of("Polygon")) == "bcd" );
+    CHECK( names(m->all_of("Shape")) == "abcd" );
+    CHECK( m->all_of("OBJECT").size() == 5 );
+    CHECK( m->all_of("Model")[0] == m->val().obj() );
+    CHECK( &m->all_of("Rect") == &m->all_of("Rect") ); // cached
+    CHECK_THROWS( m->all_of("Unknown") );
+
+    (*m)["shapes"].append((*m)["shapes"][0]);
+    CHECK( m->all_of("Circle").size() == 1 );
+    m->reset_type_index();
+    CHECK( m->all_of("Circle").size() == 2 );
+}
+
+TEST_CASE("model_traversal", "[textx/model]")
+{
+    auto mm = textx::metamodel_from_str(R"(
+        Model: packages+=Package;
+        Package: 'package' name=ID '{' items*=Item '}';
+        Item: Package | Entity;
+        Entity: 'entity' name=ID ('->' ref=[Entity])?;
+    )");
+    auto m = mm->model_from_str("package A { entity a1 package B { entity b1 -> a1 } entity a2 } package C { }");
+    auto names = [](auto range) {
+        std::string res;
+        for (auto &obj: range) {
+            if (obj.has_attr("name")) res += obj["name"].str();
+        }
+        return res;
+    };
+    CHECK( names(textx::object::objects(m->val())) == "Aa1Bb1a2C" );
+    CHECK( names(textx::object::objects(m->val(), *mm, mm->type_id("Entity"))) == "a1b1a2" );
+    CHECK( names(textx::object::objects(m->val(), *mm, mm->type_id("Item"))) == "Aa1Bb1a2C" ); // all packages are items
+
+    // values incl. strings and references (references are not followed)
+    size_t refs = 0, strs = 0;
+    for (auto &v: textx::object::tree(m->val())) {
+        if (v.is_ref()) refs++;
+        if (v.is_str()) strs++;
+    }
+    CHECK( refs == 1 );
+    CHECK( strs == 6 );
+
+    // pruning with the iterator
+    std::string pruned;
+    for (auto p=textx::object::objects(m->val()).begin(); p!=std::default_sentinel; ++p) {
+        if (p->type=="Package") pruned += (*p)["name"].str();
+        if (p->type=="Package" && (*p)["name"].str()=="B") p.skip_children();
+    }
+    CHECK( pruned == "ABC" );
+
+    // pre/post order hooks
+    std::string order;
+    textx::object::walk(m->val(), [&](textx::object::Object& obj) {
+        if (!obj.has_attr("name")) return textx::object::WalkAction::descend;
+        order += "<"+obj["name"].str();
+        return obj["name"].str()=="B" ? textx::object::WalkAction::prune : textx::object::WalkAction::descend;
+    }, [&](textx::object::Object& obj) {
+        if (obj.has_attr("name")) order += obj["name"].str()+">";
+    });
+    CHECK( order == "<A<a1a1><BB><a2a2>A><CC>" );
+    std::string until_b1;
+    textx::object::walk(m->val(), [&](textx::object::Object& obj) {
+        if (obj.has_attr("name")) until_b1 += obj["name"].str();
+        return (obj.has_attr("name") && obj["name"].str()=="b1") ? textx::object::WalkAction::stop : textx::object::WalkAction::descend;
+    });
+    CHECK( until_b1 == "Aa1Bb1" );
+
+    // deep models do not use the call stack
+    auto root = std::make_shared<textx::object::Object>(nullptr, textx::arpeggio::TextPosition{});
+    auto obj = root;
+    for (size_t i=0;i<10000;i++) {
+        auto child = std::make_shared<textx::object::Object>(obj, textx::arpeggio::TextPosition{});
+        obj->attributes.insert("child") = textx::object::AttributeValue{textx::object::Value{child, {}}};
+        obj = child;
+    }
+    textx::object::Value root_value{root, {}};
+    size_t n = 0, max_depth = 0;
+    for (auto p=textx::object::objects(root_value).begin(); p!=std::default_sentinel; ++p) {
+        n++;
+        max_depth = std::max(max_depth, p.depth());
+    }
+    CHECK( n == 10001 );
+    CHECK( max_depth == 10000 );
+
+    // ... and are destroyed w/o using the call stack (at the end of the scope)
+}
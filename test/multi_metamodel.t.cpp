@@ -13,6 +13,17 @@ TEST_CASE("metamodel_importing_other_metamodels1", "[textx/multi_metamodel]")
     CHECK(mm->get_fqn_for_rule("A") == "SimpleBaseBase.A");
     CHECK(mm->get_fqn_for_rule("SimpleBase.A") == "SimpleBaseBase.A");
     CHECK(mm->get_fqn_for_rule("Simple.A") == "SimpleBaseBase.A");
+
+    // symbol table (plain and qualified names, string_view keys)
+    std::string_view a = "SimpleBase.A";
+    CHECK(&mm->find_rule(a, false) == &mm->find_rule("A", false));
+    CHECK(&(*mm)[a.substr(11)] == &mm->find_rule(a, true));
+    CHECK(mm->get_fqn_for_rule(a.substr(11)) == "SimpleBaseBase.A");
+    CHECK(mm->has_rule("Simple.Model", false));
+    CHECK(mm->has_rule("BUILTIN.ID", false));
+    CHECK(!mm->has_rule("Unknown", true));
+    CHECK_THROWS(mm->find_rule("Unknown", true));
+    CHECK_THROWS(mm->get_fqn_for_rule("Unknown"));
 }
 
 TEST_CASE("metamodel_importing_other_metamodels_circular", "[textx/multi_metamodel]")
@@ -86,6 +97,27 @@ TEST_CASE("metamodel_referencing_other_metamodels", "[textx/multi_metamodel]")
         auto fn = std::filesystem::path(__FILE__).parent_path().append("multi_metamodel/referenced_metamodel/model/data_flow.eflow");
         auto m = workspace->model_from_file(fn);
 
+        // type ids of objects from the referenced metamodel are translated
+        auto a1 = m->fqn("A1");
+        auto point = (*a1)["inp"].obj();
+        REQUIRE( point != nullptr );
+        auto mm_flow = m->tx_metamodel();
+        auto mm_data = point->tx_model()->tx_metamodel();
+        CHECK( point->type_space == mm_data->tx_type_space() );
+        CHECK( point->type_space != mm_flow->tx_type_space() );
+        CHECK( mm_flow->is_instance(*point, mm_flow->type_id("Data.Data")) );
+        CHECK( !mm_flow->is_instance(*point, mm_flow->type_id("Algo")) );
+        CHECK( mm_flow->is_instance(*point, mm_flow->type_id("OBJECT")) );
+        CHECK( mm_flow->type_id(*point) == mm_flow->type_id("Data.Data") );
+
+        // type index over imported models and the workspace
+        CHECK( m->all_of("Algo").size() == 2 );
+        CHECK( m->all_of("Data.Data").size() == 0 );
+        CHECK( m->all_of_including_imports("Data.Data").size() == 3 );
+        CHECK( m->all_of_including_imports("Data.Data")[0] == point );
+        CHECK( workspace->all_of("Algo").size() == 2 );
+        CHECK( workspace->all_of("OBJECT").size() == m->all_of_including_imports("OBJECT").size() );
+
         //TODO: test other files.
     }
 }
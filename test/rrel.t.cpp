@@ -524,3 +524,134 @@ TEST_CASE("test_rrel_navigation_with_fixed_str", "[textx/rrel]")
         # using myFoo = Foo  # --> not found 
     )#");
 }
+
+TEST_CASE("rrel_postponed_references", "[textx/rrel]")
+{
+    auto mm = textx::metamodel_from_str(R"#(
+        Model: as+=A links+=Link;
+        A: 'A' name=ID '{' ms*=M '}';
+        M: 'M' name=ID;
+        Link: 'link' m=[M] 'in' a=[A];
+    )#");
+    struct CountingResolver : textx::scoping::RefResolver {
+        textx::rrel::RRELScopeProvider rrel{".~a.ms"};
+        mutable size_t calls = 0;
+        std::tuple<std::shared_ptr<textx::object::Object>, textx::scoping::MatchedPath> resolve(std::shared_ptr<textx::object::Object> origin, std::string obj_name, std::optional<std::string> target_type) const override {
+            calls++;
+            return rrel.resolve(origin, obj_name, target_type);
+        }
+    };
+    auto resolver = std::make_unique<CountingResolver>();
+    auto &counting = *resolver;
+    mm->set_resolver("Link.m", std::move(resolver));
+
+    // "m" depends on "a" (resolved later in traversal order): resolved again after "a"
+    auto m = mm->model_from_str("A a1 { M x M y } A a2 { M x } link y in a1 link x in a2 link x in a1");
+    CHECK( counting.calls == 6 );
+    CHECK( m->val()["links"][0]["m"].obj() == m->fqn("a1.y") );
+    CHECK( m->val()["links"][1]["m"].obj() == m->fqn("a2.x") );
+    CHECK( m->val()["links"][2]["m"].obj() == m->fqn("a1.x") );
+
+    // postponed references of unresolved references are reported as not found
+    CHECK_THROWS_WITH( mm->model_from_str("A a1 { M x } link x in a1 link x in a3"),
+        Catch::Matchers::Contains("ref 'x' not found at 1:32;\nref 'a3' not found at 1:37;") );
+}
+
+namespace {
+    /** the coroutine based evaluation (former find_object_with_path) as reference */
+    textx::rrel::py::RRELResult find_with_generators(std::shared_ptr<textx::object::Object> obj, std::vector<std::string> lookup, textx::rrel::RRELExpression& rrel_tree) {
+        std::vector<std::unordered_set<std::pair<const textx::object::Object*, const textx::rrel::RRELBase*>,textx::utils::pair_hash>> visited(lookup.size()+1);
+        auto allowed = [&](std::shared_ptr<textx::object::Object> o, std::vector<std::string> lookup_list, const textx::rrel::RRELBase* e) {
+            return visited[lookup_list.size()].insert({o.get(), e}).second;
+        };
+        for (const textx::rrel::py::RRELInternalResult res : rrel_tree.get_next_matches({obj->tx_model()->tx_metamodel(), obj, lookup, {}}, allowed, true)) {
+            if (std::holds_alternative<textx::scoping::Postponed>(res)) return textx::scoping::Postponed{};
+            auto &d = std::get<0>(res);
+            if (d.lookup_list.size()==0 && d.obj!=nullptr) return textx::rrel::py::RRELResultData{d.obj, d.matched_path};
+        }
+        return textx::rrel::py::RRELResultData{nullptr,{}};
+    }
+    std::vector<std::string> split_dots(const std::string& s) {
+        std::vector<std::string> res;
+        std::istringstream in{s};
+        for (std::string part; std::getline(in, part, '.');) {
+            if (part.size()>0) res.push_back(part);
+        }
+        return res;
+    }
+}
+
+TEST_CASE("rrel_compiled_evaluation_equals_generators", "[textx/rrel]")
+{
+    auto mm = textx::metamodel_from_str(metamodel_str);
+    auto m = mm->model_from_str(modeltext);
+    auto rec = m->fqn("P2.Part2.rec");
+    std::vector<std::string> expressions = {
+        "packages.classes", "packages*.classes.attributes", "(packages)", "packages*", "..", "...", "^packages*.classes",
+        "parent(Package).classes", ".(..).(..)", "...(.).(.)", "^classes,packages*.classes", "~packages.classes*.attributes",
+        "(..)*.(packages,classes)", "packages.'Inner'~packages.classes", "^~packages*.classes.attributes"
+    };
+    std::vector<std::string> lookups = { "", "P2", "P1.Part1", "P2.Part2", "P2.Part2.rec", "P2.Inner.Inner.inner", "Inner", "rec", "C2.p1", "x.y" };
+    for (auto start: {m->val().obj(), rec}) {
+        for (auto &e: expressions) {
+            auto rrel = textx::rrel::create_RREL_expression(e);
+            for (auto &l: lookups) {
+                INFO( e << " / " << l );
+                auto expected = std::get<0>(find_with_generators(start, split_dots(l), *rrel));
+                auto res = std::get<0>(textx::rrel::find_object_with_path(start, l, *rrel));
+                CHECK( res.obj == expected.obj );
+                REQUIRE( res.matched_path.size() == expected.matched_path.size() );
+                for (size_t i=0;i<res.matched_path.size();i++) {
+                    CHECK( res.matched_path[i].lock() == expected.matched_path[i].lock() );
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("rrel_compiled_evaluation_speed", "[textx/rrel][.][benchmark]")
+{
+    auto mm = textx::metamodel_from_str(metamodel_str);
+    auto m = mm->model_from_str(modeltext);
+    auto rec = m->fqn("P2.Part2.rec");
+    auto rrel = textx::rrel::create_RREL_expression("^packages*.classes.attributes");
+    std::vector<std::string> lookup = {"P2", "Inner", "Inner", "inner"};
+    REQUIRE( std::get<0>(textx::rrel::find_object_with_path(rec, lookup, *rrel)).obj == std::get<0>(find_with_generators(rec, lookup, *rrel)).obj );
+    BENCHMARK("generators") { return find_with_generators(rec, lookup, *rrel); };
+    BENCHMARK("compiled") { return textx::rrel::find_object_with_path(rec, lookup, *rrel); };
+}
+
+TEST_CASE("rrel_expression_cache_and_find_all", "[textx/rrel]")
+{
+    auto mm = textx::metamodel_from_str(metamodel_str);
+    auto m = mm->model_from_str(modeltext);
+    auto rec = m->fqn("P2.Part2.rec");
+
+    auto e1 = textx::rrel::get_RREL_expression("^packages*.classes.attributes");
+    CHECK( textx::rrel::get_RREL_expression("^packages*.classes.attributes") == e1 );
+    CHECK( textx::rrel::get_RREL_expression("packages*") != e1 );
+
+    std::vector<std::string> lookups = { "P2.Part2.rec", "P2.Inner.Inner.inner", "P2.C2.p2a", "x.y", "P1.Part1" };
+    auto res = textx::rrel::find_all(rec, lookups, "^packages*.classes.attributes");
+    REQUIRE( res.size() == lookups.size() );
+    for (size_t i=0;i<lookups.size();i++) {
+        CHECK( res[i] == textx::rrel::find(rec, lookups[i], "^packages*.classes.attributes") );
+    }
+    CHECK( res[0] == rec );
+    CHECK( res[1] == m->fqn("P2.Inner.Inner.inner") );
+    CHECK( res[3] == nullptr );
+    CHECK( res[4] == nullptr );
+
+    auto paths = textx::rrel::find_objects_with_path(rec, lookups, *e1, "Attribute");
+    REQUIRE( paths.size() == lookups.size() );
+    CHECK( textx::rrel::build_fqn(std::get<0>(paths[2]).matched_path) == "P2.C2.p2a" );
+
+    // the cache and the evaluation are thread-safe
+    std::vector<std::shared_ptr<textx::object::Object>> found(100);
+    textx::utils::parallel_for(found.size(), 4, [&](size_t i) {
+        found[i] = textx::rrel::find(rec, lookups[i%lookups.size()], "^packages*.classes.attributes");
+    });
+    for (size_t i=0;i<found.size();i++) {
+        CHECK( found[i] == res[i%lookups.size()] );
+    }
+}
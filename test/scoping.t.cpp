@@ -3,6 +3,10 @@
 #include <sstream>
 #include "textx/metamodel.h"
 #include "textx/scoping.h"
+#include "textx/workspace.h"
+#include <thread>
+#include <set>
+#include <mutex>
 
 TEST_CASE("model_ref1", "[textx/scoping]")
 {
@@ -21,6 +25,8 @@ TEST_CASE("model_ref1", "[textx/scoping]")
             CHECK( m->val()["items"][2]["name"].str() == "C" );
             CHECK( m->val()["ref"].is_ref() );
             CHECK( m->val()["ref"].ref().name == "B" ); // the reference string (the identifier to find the obj)
+            CHECK( m->val()["ref"].ref().name.data() == m->tx_text().data()+m->tx_text().rfind('B') ); // view into the model text
+            static_assert(!std::is_constructible_v<textx::object::ObjectRef, std::shared_ptr<textx::Model>, std::string, std::shared_ptr<textx::object::Object>>); // only created by the model
             CHECK( m->val()["ref"]["name"].str() == "B" ); // the name of the (found) referenced element
             CHECK( m->val()["ref"].obj() == m->val()["items"][1].obj() );
         }
@@ -254,3 +260,340 @@ TEST_CASE("model_ref1_type_check", "[textx/scoping]")
         }
     }
 }
+
+TEST_CASE("model_ref_resolver_table", "[textx/scoping]")
+{
+    auto grammar1 = R"#(
+        Model: packages+=Package refs+=Ref;
+        Package: 'package' name=ID '{' items+=Item '}';
+        Item: 'item' name=ID;
+        Ref: 'ref' ref=[Item|FQN];
+        FQN: ID ('.' ID)*;
+    )#";
+    auto mm = textx::metamodel_from_str(grammar1);
+    auto ref_id = mm->type_id("Ref");
+    auto attr_id = mm->find_rule("Ref", true).tx_attribute_id("ref");
+    CHECK( &mm->get_resolver(ref_id, attr_id) == &mm->get_resolver("Ref", "ref") );
+
+    auto m1 = mm->model_from_str("package P { item A } ref A");
+    CHECK( m1->val()["refs"][0]["ref"].ref().rule_id == ref_id );
+    CHECK( m1->val()["refs"][0]["ref"].ref().attr_id == attr_id );
+    CHECK( mm->tx_rule(ref_id).tx_attribute_info(attr_id).type.value() == "Item" ); // the target type
+    CHECK( m1->val()["refs"][0]["ref"].obj() == m1->fqn("P.A") );
+
+    // the table is updated after set_resolver
+    mm->set_resolver("*.ref", std::make_unique<textx::scoping::FQNRefResolver>());
+    CHECK( &mm->get_resolver(ref_id, attr_id) == &mm->get_resolver("Ref", "ref") );
+    CHECK_THROWS( mm->model_from_str("package P { item A } ref A") );
+    auto m2 = mm->model_from_str("package P { item A } ref P.A");
+    CHECK( m2->val()["refs"][0]["ref"].obj() == m2->fqn("P.A") );
+}
+
+TEST_CASE("model_ref_name_index", "[textx/scoping]")
+{
+    auto grammar1 = R"#(
+        Model: packages+=Package refs+=Ref;
+        Package: 'package' name=ID '{' items*=Item '}';
+        Item: 'item' name=ID;
+        Ref: 'ref' ref=[Item];
+    )#";
+    auto mm = textx::metamodel_from_str(grammar1);
+
+    // the first object in traversal order is found
+    auto m = mm->model_from_str("package P { item A item B } package Q { item A } ref A ref B");
+    CHECK( m->val()["refs"][0]["ref"].obj() == m->val()["packages"][0]["items"][0].obj() );
+    CHECK( m->val()["refs"][1]["ref"].obj() == m->val()["packages"][0]["items"][1].obj() );
+    REQUIRE( m->objects_named("A").size() == 2 );
+    CHECK( m->objects_named("A")[1] == m->val()["packages"][1]["items"][0].obj() );
+    CHECK( m->objects_named("X").size() == 0 );
+
+    // the first object decides (even if a later one has the expected type)
+    CHECK_THROWS_WITH( mm->model_from_str("package A { item A } ref A"), Catch::Matchers::Contains("'A' has not expected type 'Item'") );
+
+    // the index is rebuilt after reset_type_index
+    auto item = std::make_shared<textx::object::Object>(m->val()["packages"][1].obj(), textx::arpeggio::TextPosition{});
+    item->type = "Item";
+    item->attributes.insert("name") = textx::object::AttributeValue{textx::object::Value{textx::object::MatchText{"C", "ID"}, {}}};
+    m->val()["packages"][1]["items"].append(textx::object::Value{item, {}});
+    CHECK( m->objects_named("C").size() == 0 );
+    m->reset_type_index();
+    REQUIRE( m->objects_named("C").size() == 1 );
+    CHECK( m->objects_named("C")[0] == item );
+}
+
+TEST_CASE("model_ref_name_index_large_model", "[textx/scoping]")
+{
+    auto mm = textx::metamodel_from_str(R"#(
+        Model: items+=Item refs+=Ref;
+        Item: 'item' name=ID;
+        Ref: 'ref' ref=[Item];
+    )#");
+    const size_t n = 2000;
+    std::ostringstream text;
+    for (size_t i=0;i<n;i++) text << "item i" << i << "\n";
+    for (size_t i=0;i<n;i++) text << "ref i" << (i*7919)%n << "\n";
+    auto m = mm->model_from_str(text.str());
+    size_t wrong = 0;
+    for (size_t i=0;i<n;i++) {
+        if (m->val()["refs"][i]["ref"].obj() != m->val()["items"][(i*7919)%n].obj()) wrong++;
+    }
+    CHECK( wrong == 0 );
+    // one index for all names (built once)
+    auto &named = m->objects_named("i1999");
+    REQUIRE( named.size() == 1 );
+    CHECK( named[0] == m->val()["items"][1999].obj() );
+    CHECK( &m->objects_named("i1999") == &named );
+    CHECK( m->objects_named("i2000").empty() );
+}
+
+TEST_CASE("model_ref_name_index_scaling", "[textx/scoping][.][benchmark]")
+{
+    auto mm = textx::metamodel_from_str(R"#(
+        Model: items+=Item refs+=Ref;
+        Item: 'item' name=ID;
+        Ref: 'ref' ref=[Item];
+    )#");
+    // resolution time per reference must not grow with the model size
+    auto model_text = [](size_t n) {
+        std::ostringstream text;
+        for (size_t i=0;i<n;i++) text << "item i" << i << "\n";
+        for (size_t i=0;i<n;i++) text << "ref i" << (i*7919)%n << "\n";
+        return text.str();
+    };
+    auto text1 = model_text(5000);
+    auto text4 = model_text(20000);
+    BENCHMARK("model with 5000 references") { return mm->model_from_str(text1); };
+    BENCHMARK("model with 20000 references") { return mm->model_from_str(text4); };
+}
+
+TEST_CASE("model_ref_fqn_child_names", "[textx/scoping]")
+{
+    auto grammar1 = R"#(
+        Model: packages+=Package refs+=Ref;
+        Package: 'package' name=ID '{' packages*=Package classes*=Class '}';
+        Class: 'class' name=ID '{' members*=Member '}';
+        Member: 'member' name=ID;
+        Ref: 'ref' ref=[Member|FQN];
+        FQN: ID ('.' ID)*;
+    )#";
+    auto mm = textx::metamodel_from_str(grammar1);
+    mm->set_resolver("Ref.ref", std::make_unique<textx::scoping::FQNRefResolver>());
+
+    // two packages "a": the second one contains the class (backtracking)
+    auto m = mm->model_from_str(R"(
+        package p {
+            package a { class X { member y } }
+            package a { class C { member x member y } }
+        }
+        ref p.a.C.y
+        ref p.a.X.y
+    )");
+    auto p = m->val()["packages"][0].obj();
+    auto names = p->child_names();
+    CHECK( names->size() == 2 );
+    CHECK( std::distance(names->named("a").begin(), names->named("a").end()) == 2 );
+    CHECK( names->named("b").empty() );
+    CHECK( p->child_names() == names ); // built once
+    CHECK( m->val()["refs"][0]["ref"].obj() == (*p)["packages"][1]["classes"][0]["members"][1].obj() );
+    CHECK( m->val()["refs"][1]["ref"].obj() == (*p)["packages"][0]["classes"][0]["members"][0].obj() );
+    CHECK( m->fqn("p.a.C.x") == (*p)["packages"][1]["classes"][0]["members"][0].obj() );
+
+    // the index is rebuilt after reset_type_index
+    auto c = (*p)["packages"][1]["classes"][0].obj();
+    auto member = std::make_shared<textx::object::Object>(c, textx::arpeggio::TextPosition{});
+    member->type = "Member";
+    member->attributes.insert("name") = textx::object::AttributeValue{textx::object::Value{textx::object::MatchText{"z", "ID"}, {}}};
+    (*c)["members"].append(textx::object::Value{member, {}});
+    CHECK( m->fqn("p.a.C.z") == nullptr );
+    m->reset_type_index();
+    CHECK( p->child_names() != names );
+    CHECK( m->fqn("p.a.C.z") == member );
+}
+
+TEST_CASE("model_parallel_resolution", "[textx/scoping]")
+{
+    auto mm = textx::metamodel_from_str(R"#(
+        Model: packages+=Package links+=Link;
+        Package: 'package' name=ID '{' items*=Item '}';
+        Item: 'item' name=ID;
+        Link: 'link' item=[Item|ID|+m:.~package.items] 'in' package=[Package] ('use' other=[Item|FQN])?;
+        FQN: ID ('.' ID)*;
+    )#");
+    mm->set_resolver("Link.other", std::make_unique<textx::scoping::FQNRefResolver>());
+    std::ostringstream text;
+    for (size_t p=0;p<20;p++) {
+        text << "package p" << p << " {";
+        for (size_t i=0;i<50;i++) text << " item i" << i;
+        text << " }\n";
+    }
+    for (size_t l=0;l<2000;l++) {
+        text << "link i" << (l*7)%50 << " in p" << l%20 << " use p" << (l*3)%20 << ".i" << l%50 << "\n";
+    }
+
+    // the results do not depend on the number of threads
+    auto targets = [&](size_t threads) {
+        mm->set_model_options({.resolver_threads=threads});
+        auto m = mm->model_from_str(text.str());
+        std::vector<std::string> res;
+        for (auto &link: m->val()["links"]) {
+            auto item = link["item"].obj();
+            res.push_back(item->parent()->operator[]("name").str()+"."+(*item)["name"].str()+"/"+link["other"]["name"].str());
+        }
+        return res;
+    };
+    auto sequential = targets(1);
+    CHECK( sequential[0] == "p0.i0/i0" );
+    CHECK( sequential[1999] == "p19.i43/i49" );
+    CHECK( targets(4) == sequential );
+    CHECK( targets(0) == sequential );
+
+    // errors do not depend on the number of threads
+    auto error = [&](size_t threads) {
+        mm->set_model_options({.resolver_threads=threads});
+        try {
+            (void)mm->model_from_str(text.str()+"link i1 in p1 use p1.xx link i2 in xx");
+        }
+        catch (std::exception& e) {
+            return std::string{e.what()};
+        }
+        return std::string{};
+    };
+    auto sequential_error = error(1);
+    CHECK_THAT( sequential_error, Catch::Matchers::Contains("ref 'p1.xx' not found") && Catch::Matchers::Contains("ref 'i2' not found") && Catch::Matchers::Contains("ref 'xx' not found") );
+    CHECK( error(4) == sequential_error );
+    mm->set_model_options({});
+}
+
+TEST_CASE("thread_pool_reused", "[textx/scoping]")
+{
+    // the threads of a pool are started once and reused by each call (e.g. rounds of resolve_references)
+    textx::utils::ThreadPool pool{4};
+    CHECK( pool.size() == 4 );
+    std::mutex mutex;
+    std::set<std::thread::id> ids;
+    for (size_t round=0;round<50;round++) {
+        std::vector<size_t> res(1000, 0);
+        pool.parallel_for(res.size(), [&](size_t i) {
+            res[i] = i*round;
+            std::lock_guard lock{mutex};
+            ids.insert(std::this_thread::get_id());
+        }, 8);
+        CHECK( res[999] == 999*round );
+    }
+    CHECK( ids.size() <= 4 );
+}
+
+TEST_CASE("model_scope_cache", "[textx/scoping]")
+{
+    auto mm = textx::metamodel_from_str(R"#(
+        Model: packages+=Package;
+        Package: 'package' name=ID '{' items*=Item uses*=Use '}';
+        Item: 'item' name=ID;
+        Use: 'use' item=[Item|ID|~packages.items] 'and' other=[Item|FQN];
+        FQN: ID ('.' ID)*;
+    )#");
+    mm->set_resolver("Use.other", std::make_unique<textx::scoping::FQNRefResolver>());
+    auto text = R"(
+        package a { item x item y use x and x use x and y use y and y }
+        package b { item x use x and x use x and a.y use x and a.y }
+    )";
+    auto targets = [](std::shared_ptr<textx::Model> m) {
+        std::vector<std::shared_ptr<textx::object::Object>> res;
+        for (auto &p: m->val()["packages"]) {
+            for (auto &u: p["uses"]) {
+                res.push_back(u["item"].obj());
+                res.push_back(u["other"].obj());
+            }
+        }
+        return res;
+    };
+
+    auto m_uncached = mm->model_from_str(text);
+    CHECK( m_uncached->tx_scope_cache() == nullptr );
+
+    mm->set_model_options({.cache_scope_results=true});
+    auto m = mm->model_from_str(text);
+    auto cache = m->tx_scope_cache();
+    REQUIRE( cache != nullptr );
+    auto res = targets(m);
+    REQUIRE( res.size() == 12 );
+    CHECK( res[0] == m->fqn("a.x") );
+    CHECK( res[3] == m->fqn("a.y") );
+    CHECK( res[6] == m->fqn("a.x") ); // "~packages.items": the first x
+    CHECK( res[7] == m->fqn("b.x") ); // FQN: the closest x
+    CHECK( res[11] == m->fqn("a.y") );
+    auto expected = targets(m_uncached);
+    for (size_t i=0;i<res.size();i++) {
+        CHECK( (*res[i])["name"].str() == (*expected[i])["name"].str() );
+        CHECK( res[i]->parent()->operator[]("name").str() == expected[i]->parent()->operator[]("name").str() );
+    }
+
+    // "~packages.items" starts at the root (shared by all origins): x, y (a), x (b), a.y (b) repeated
+    // FQN: the search below the package is shared by its uses
+    CHECK( cache->hits() == 7 );
+    CHECK( cache->misses() == 7 );
+
+    // cached results (incl. not found)
+    auto &rrel = mm->get_resolver("Use", "item");
+    auto use = (*m->fqn("b"))["uses"][0].obj();
+    CHECK( std::get<0>(rrel.resolve(use, "x", "Item")) == m->fqn("a.x") );
+    CHECK( std::get<0>(rrel.resolve(use, "z", "Item")) == nullptr );
+    CHECK( std::get<0>(rrel.resolve(use, "z", "Item")) == nullptr );
+    CHECK( cache->hits() == 9 );
+
+    m->reset_type_index();
+    CHECK( cache->size() == 0 );
+}
+
+TEST_CASE("model_lazy_references", "[textx/scoping]")
+{
+    auto mm = textx::metamodel_from_str(R"#(
+        Model: as+=A links+=Link;
+        A: 'A' name=ID '{' ms*=M '}';
+        M: 'M' name=ID;
+        Link: 'link' m=[M|ID|.~a.ms] 'in' a=[A];
+    )#");
+    auto text = "A a1 { M x M y } A a2 { M x } link y in a1 link x in a2 link x in a1";
+    auto eager = mm->model_from_str(text);
+
+    mm->set_model_options({.lazy_references=true});
+    auto m = mm->model_from_str(text);
+    auto &links = m->val()["links"];
+    CHECK( links[0]["m"].ref().obj.lock() == nullptr ); // not resolved yet
+    CHECK( links[0]["a"].ref().obj.lock() == nullptr );
+
+    // "m" is resolved on first access (and "a" on demand by the RREL navigation)
+    CHECK( links[0]["m"].obj() == m->fqn("a1.y") );
+    CHECK( links[0]["a"].ref().obj.lock() == m->fqn("a1") );
+    CHECK( links[1]["a"].ref().obj.lock() == nullptr );
+
+    // concurrent first accesses
+    std::vector<std::shared_ptr<textx::object::Object>> targets(3);
+    textx::utils::parallel_for(targets.size(), 3, [&](size_t i) { targets[i] = links[i]["m"].obj(); });
+    for (size_t i=0;i<targets.size();i++) {
+        CHECK( (*targets[i])["name"].str() == eager->val()["links"][i]["m"]["name"].str() );
+        CHECK( targets[i]->parent() == links[i]["a"].obj() );
+    }
+
+    // unresolvable references: nullptr on access, errors with validate_all_references
+    auto bad = mm->model_from_str("A a1 { M x } link x in a1 link x in a3");
+    CHECK( bad->val()["links"][1]["a"].obj() == nullptr );
+    CHECK( bad->val()["links"][0]["m"].obj() == bad->fqn("a1.x") );
+    CHECK_THROWS_WITH( bad->validate_all_references(), Catch::Matchers::Contains("ref 'a3' not found at 1:37;") );
+
+    auto good = mm->model_from_str(text);
+    CHECK_NOTHROW( good->validate_all_references() );
+    CHECK( good->val()["links"][2]["m"].ref().obj.lock() == good->fqn("a1.x") );
+
+    // one lock per workspace: resolutions in other workspaces are not blocked
+    auto other = textx::Workspace::create();
+    CHECK( other->tx_lazy_resolution_mutex() != mm->tx_default_workspace()->tx_lazy_resolution_mutex() );
+    auto m2 = mm->model_from_str(text);
+    std::shared_ptr<textx::object::Object> resolved = nullptr;
+    {
+        std::lock_guard lock{*other->tx_lazy_resolution_mutex()};
+        std::thread t{[&]() { resolved = m2->val()["links"][0]["m"].obj(); }};
+        t.join();
+    }
+    CHECK( resolved == m2->fqn("a1.y") );
+}
@@ -4,6 +4,9 @@
 #include <iostream>
 #include <sstream>
 #include <filesystem>
+#include <fstream>
+#include <thread>
+#include <atomic>
 
 TEST_CASE("simple_importURI_ab", "[textx/simple_importURI]")
 {
@@ -79,3 +82,212 @@ TEST_CASE("simple_importURI_cd", "[textx/simple_importURI]")
     CHECK( (*m2)["refs"][0]["ref"].is_resolved() );
     CHECK( (*m2)["refs"][0]["ref"].obj() == m1->fqn("C2"));
 }
+
+TEST_CASE("simple_importURI_exported_symbols", "[textx/simple_importURI]")
+{
+    auto p_grammar = std::filesystem::path(__FILE__).parent_path().append("metamodel.tx");
+    auto mm = textx::metamodel_from_file(p_grammar);
+
+    auto w = textx::Workspace::create();
+    w->set_default_metamodel(mm);
+    auto ma = w->model_from_file(std::filesystem::path(__FILE__).parent_path().append("a.model"));
+    auto mb = w->model_from_file(std::filesystem::path(__FILE__).parent_path().append("b.model"));
+    CHECK( ma->tx_workspace() == w );
+
+    auto &symbols = w->tx_exported_symbols();
+    CHECK( symbols.size() == 2 );
+    CHECK( symbols.contains(ma.get()) );
+    CHECK( symbols.contains(mb.get()) );
+    CHECK( (*ma)["refs"][0]["ref"].obj() == mb->fqn("B2") );
+
+    // the builtin models are not known to the workspace: searched directly
+    size_t direct_searches = 0;
+    auto direct = [&](textx::Model&) -> std::shared_ptr<textx::object::Object> { direct_searches++; return nullptr; };
+    auto n_imports = ma->tx_imported_models().size();
+    CHECK( symbols.find_name("B1", ma->tx_imported_models(), direct) == mb->fqn("B1") );
+    CHECK( direct_searches == 0 );
+    CHECK( symbols.find_fqn("B2", ma->tx_imported_models(), direct) == mb->fqn("B2") );
+    CHECK( symbols.find_name("A1", ma->tx_imported_models(), direct) == nullptr ); // own model
+    CHECK( direct_searches == n_imports-1 );
+
+    mb->reset_type_index(); // re-indexed on the next lookup
+    CHECK( symbols.find_name("B2", ma->tx_imported_models(), direct) == mb->fqn("B2") );
+}
+
+TEST_CASE("simple_importURI_parallel_loading", "[textx/simple_importURI]")
+{
+    auto p_grammar = std::filesystem::path(__FILE__).parent_path().append("metamodel.tx");
+
+    // a tree of imports: each file imports its two children and the root (cycles)
+    auto dir = std::filesystem::temp_directory_path()/"textx_simple_importURI_parallel_loading";
+    std::filesystem::create_directories(dir);
+    dir = std::filesystem::canonical(dir);
+    constexpr size_t n = 40;
+    auto children = [&](size_t i) {
+        std::vector<size_t> res;
+        for (auto c: {2*i+1, 2*i+2}) if (c<n) res.push_back(c);
+        return res;
+    };
+    for (size_t i=0;i<n;i++) {
+        std::ofstream f(dir/("m"+std::to_string(i)+".model"));
+        for (auto c: children(i)) f << "import \"m" << c << ".model\"\n";
+        if (i>0) f << "import \"m0.model\"\n";
+        f << "def D" << i << "\n";
+        for (auto c: children(i)) f << "ref D" << c << "\n";
+        if (i>0) f << "ref D0\n";
+    }
+
+    for (size_t threads: {1, 4}) {
+        auto mm = textx::metamodel_from_file(p_grammar);
+        mm->set_model_options({.import_threads=threads});
+        auto m0 = mm->model_from_file(dir/"m0.model");
+
+        // each file is loaded once, the imports are linked in order:
+        std::vector<std::shared_ptr<textx::Model>> models(n);
+        models[0] = m0;
+        for (size_t i=0;i<n;i++) {
+            REQUIRE( models[i] != nullptr );
+            auto &imports = models[i]->tx_imported_models();
+            size_t k = 0;
+            for (auto c: children(i)) {
+                REQUIRE( imports.size() > k );
+                models[c] = imports[k++].lock();
+                CHECK( std::filesystem::path(models[c]->tx_filename()).filename() == "m"+std::to_string(c)+".model" );
+            }
+            if (i>0) {
+                REQUIRE( imports.size() > k );
+                CHECK( imports[k].lock() == m0 );
+            }
+        }
+        for (size_t i=0;i<n;i++) {
+            size_t k = 0;
+            for (auto c: children(i)) {
+                CHECK( (*models[i])["refs"][k++]["ref"].obj() == models[c]->fqn("D"+std::to_string(c)) );
+            }
+            if (i>0) {
+                CHECK( (*models[i])["refs"][k]["ref"].obj() == m0->fqn("D0") );
+            }
+        }
+    }
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("simple_importURI_refresh", "[textx/simple_importURI]")
+{
+    auto p_grammar = std::filesystem::path(__FILE__).parent_path().append("metamodel.tx");
+    auto mm = textx::metamodel_from_file(p_grammar);
+
+    auto dir = std::filesystem::temp_directory_path()/"textx_simple_importURI_refresh";
+    std::filesystem::create_directories(dir);
+    dir = std::filesystem::canonical(dir);
+    auto write = [&](std::string fn, std::string text) {
+        auto p = dir/fn;
+        auto mtime = std::filesystem::exists(p) ? std::filesystem::last_write_time(p) : std::filesystem::file_time_type{};
+        std::ofstream{p} << text;
+        std::filesystem::last_write_time(p, std::max(std::filesystem::last_write_time(p), mtime+std::chrono::seconds{1}));
+    };
+    write("b.model", "def B1 def B2");
+    write("a.model", "import \"b.model\" def A1 ref B2");
+    write("c.model", "import \"a.model\" def C1 ref A1");
+
+    auto w = textx::Workspace::create();
+    w->set_default_metamodel(mm);
+    auto mc = w->model_from_file(dir/"c.model");
+    auto ma = w->model_from_file(dir/"a.model");
+    auto mb = w->model_from_file(dir/"b.model");
+    CHECK( (*ma)["refs"][0]["ref"].obj() == mb->fqn("B2") );
+    CHECK( mb->tx_importers() == std::vector{ma} ); // recorded when the imports are linked
+    CHECK( w->refresh().empty() );
+
+    write("b.model", "def B1 def B2"); // touched only
+    CHECK( w->refresh().empty() );
+    CHECK( w->model_from_file(dir/"b.model") == mb );
+
+    // the changed file is reloaded, the importers are resolved again
+    write("b.model", "def B0 def B2");
+    CHECK( w->refresh() == std::vector<std::string>{(dir/"b.model").string()} );
+    auto mb2 = w->model_from_file(dir/"b.model");
+    CHECK( mb2 != mb );
+    CHECK( w->model_from_file(dir/"a.model") == ma );
+    CHECK( ma->tx_imported_models().at(0).lock() == mb2 );
+    CHECK( mb2->tx_importers() == std::vector{ma} );
+    CHECK( mb->tx_importers().empty() );
+    CHECK( (*ma)["refs"][0]["ref"].obj() == mb2->fqn("B2") );
+    CHECK( (*mc)["refs"][0]["ref"].obj() == ma->fqn("A1") );
+
+    // errors: nothing is changed
+    write("b.model", "def B0 def B3");
+    CHECK_THROWS( w->refresh() );
+    CHECK( w->model_from_file(dir/"b.model") == mb2 );
+    CHECK( w->tx_exported_symbols().contains(mb2.get()) );
+    CHECK( mb2->tx_importers() == std::vector{ma} );
+    CHECK( ma->tx_imported_models().at(0).lock() == mb2 );
+    CHECK( (*ma)["refs"][0]["ref"].obj() == mb2->fqn("B2") );
+    CHECK_THROWS( w->refresh() ); // still changed
+
+    write("b.model", "def B0 def B2 def B3");
+    CHECK( w->refresh().size() == 1 );
+    CHECK( (*ma)["refs"][0]["ref"].obj() == w->model_from_file(dir/"b.model")->fqn("B2") );
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("simple_importURI_refresh_staged", "[textx/simple_importURI]")
+{
+    auto p_grammar = std::filesystem::path(__FILE__).parent_path().append("metamodel.tx");
+    auto dir = std::filesystem::temp_directory_path()/"textx_simple_importURI_refresh_staged";
+    std::filesystem::create_directories(dir);
+    dir = std::filesystem::canonical(dir);
+    auto write = [&](std::string fn, std::string text) {
+        auto p = dir/fn;
+        auto mtime = std::filesystem::exists(p) ? std::filesystem::last_write_time(p) : std::filesystem::file_time_type{};
+        std::ofstream{p} << text;
+        std::filesystem::last_write_time(p, std::max(std::filesystem::last_write_time(p), mtime+std::chrono::seconds{1}));
+    };
+
+    for (bool lazy: {false, true}) {
+        auto mm = textx::metamodel_from_file(p_grammar);
+        mm->set_model_options({.resolver_threads=4, .lazy_references=lazy});
+        std::string b = "def B0";
+        std::string a = "import \"b.model\"";
+        for (int i=0;i<200;i++) {
+            b += " def B"+std::to_string(i+1);
+            a += " ref B"+std::to_string(i);
+        }
+        write("b.model", b);
+        write("a.model", a);
+        auto w = textx::Workspace::create();
+        w->set_default_metamodel(mm);
+        auto ma = w->model_from_file(dir/"a.model");
+        auto mb = w->model_from_file(dir/"b.model");
+        CHECK( (*ma)["refs"][199]["ref"].obj() == mb->fqn("B199") );
+
+        // a failing refresh (B199 removed): other threads only see the published models, the importer is not modified
+        if (!lazy) {
+            write("b.model", b.substr(0, b.rfind(" def B199")));
+            std::atomic<bool> done = false;
+            std::atomic<size_t> unpublished = 0;
+            std::thread reader{[&]() {
+                while (!done) {
+                    if (w->model_from_file(dir/"b.model")!=mb) unpublished++;
+                }
+            }};
+            CHECK_THROWS( w->refresh() );
+            done = true;
+            reader.join();
+            CHECK( unpublished == 0 );
+            CHECK( ma->tx_imported_models().at(0).lock() == mb );
+            CHECK( (*ma)["refs"][199]["ref"].obj() == mb->fqn("B199") );
+        }
+
+        // committed at once
+        write("b.model", "def X "+b);
+        CHECK( w->refresh().size() == 1 );
+        auto mb2 = w->model_from_file(dir/"b.model");
+        CHECK( mb2 != mb );
+        CHECK( ma->tx_imported_models().at(0).lock() == mb2 );
+        for (int i=0;i<200;i++) {
+            CHECK( (*ma)["refs"][i]["ref"].obj() == mb2->fqn("B"+std::to_string(i)) );
+        }
+    }
+    std::filesystem::remove_all(dir);
+}